@@ -0,0 +1,96 @@
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <workspace/workspace.hpp>
+
+#include "latency.h"
+
+// Submit-to-start and submit-to-complete latency percentiles for each wait strategy,
+// task shape and number of producers. Output: JSON.
+
+struct shape {
+    const char* name;
+    int divisor;  // run fewer tasks of the slow shapes
+    std::function<void()> body;
+};
+
+static volatile uint32_t sink;
+
+int main(int argn, char** argvs) {
+    int thread_nums, task_nums, producer_nums;
+    if (argn == 4 || argn == 5) {
+        thread_nums = atoi(argvs[1]);
+        task_nums = atoi(argvs[2]);
+        producer_nums = atoi(argvs[3]);
+    } else {
+        fprintf(stderr, "Invalid parameter! usage: [threads + tasks + max producers] (+ output.json)\n");
+        return -1;
+    }
+    std::ofstream file;
+    if (argn == 5) file.open(argvs[4]);
+    std::ostream& out = argn == 5 ? file : std::cout;
+
+    // 64 MiB of cache-hostile memory for the memory-bound shape
+    std::vector<uint32_t> memory(16 << 20);
+    std::mt19937 gen(42);
+    for (auto& each : memory) each = gen();
+
+    std::vector<shape> shapes = {
+        {"empty", 1, [] {}},
+        {"cpu_1us", 1, [] { spin_for(1000); }},
+        {"cpu_10us", 10, [] { spin_for(10000); }},
+        {"cpu_100us", 100, [] { spin_for(100000); }},
+        {"memory", 10,
+         [&memory] {
+             uint32_t idx = static_cast<uint32_t>(now_ns());
+             for (int i = 0; i < 256; ++i) idx = memory[idx % memory.size()];  // dependent random loads
+             sink = idx;
+         }},
+        {"sleep_50us", 100, [] { std::this_thread::sleep_for(std::chrono::microseconds(50)); }},
+    };
+
+    out << "{\"benchmark\":\"latency\",\"threads\":" << thread_nums << ",\"runs\":[";
+    bool first = true;
+    for (auto strategy : {wsp::waitstrategy::lowlatancy, wsp::waitstrategy::balance, wsp::waitstrategy::blocking}) {
+        for (auto& each : shapes) {
+            for (int producers = 1; producers <= producer_nums; ++producers) {
+                int tasks = std::max(task_nums / each.divisor, producers);
+                std::vector<int64_t> submitted(tasks), started(tasks), completed(tasks);
+                {
+                    wsp::workbranch br(thread_nums, strategy);
+                    std::vector<std::thread> threads;
+                    for (int p = 0; p < producers; ++p) {
+                        threads.emplace_back([&, p] {
+                            for (int i = p; i < tasks; i += producers) {
+                                submitted[i] = now_ns();
+                                br.submit([&, i] {
+                                    started[i] = now_ns();
+                                    each.body();
+                                    completed[i] = now_ns();
+                                });
+                            }
+                        });
+                    }
+                    for (auto& t : threads) t.join();
+                    br.wait_tasks();
+                }
+
+                wsp::histogram_snapshot to_start, to_complete;
+                for (int i = 0; i < tasks; ++i) {
+                    to_start.record(started[i] - submitted[i]);
+                    to_complete.record(completed[i] - submitted[i]);
+                }
+                out << (first ? "\n" : ",\n") << "{\"strategy\":\"" << strategy_name(strategy) << "\",\"shape\":\""
+                    << each.name << "\",\"producers\":" << producers << ",\"tasks\":" << tasks
+                    << ",\"submit_to_start_ns\":";
+                write_percentiles(out, to_start);
+                out << ",\"submit_to_complete_ns\":";
+                write_percentiles(out, to_complete);
+                out << "}" << std::flush;
+                first = false;
+            }
+        }
+    }
+    out << "\n]}" << std::endl;
+}
@@ -0,0 +1,125 @@
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <workspace/workspace.hpp>
+
+#include "latency.h"
+
+// Open-loop load generator: tasks are submitted at a target rate (fixed or Poisson) whatever the
+// pool does, and latency is measured from the intended send time, so a stalled pool is charged
+// for the tasks it delayed (coordinated-omission correction). The rate is swept from light load
+// past the nominal capacity to find the saturation knee of each configuration. Output: JSON.
+
+struct result {
+    double target;    // tasks/s asked for
+    double achieved;  // tasks/s completed
+    wsp::histogram_snapshot corrected;    // intended send -> complete
+    wsp::histogram_snapshot uncorrected;  // actual submit -> complete
+};
+
+template <typename Executor>
+void wait_all(Executor& ex) {
+    ex.wait_tasks();
+}
+
+void wait_all(wsp::workspace& spc) {
+    spc.for_each([](wsp::workbranch& each) { each.wait_tasks(); });
+}
+
+template <typename Executor>
+result run(Executor& ex, double rate, bool poisson, int64_t service_ns, int64_t duration_ns) {
+    auto tasks = static_cast<size_t>(std::max(1.0, rate * duration_ns / 1e9));
+    std::vector<int64_t> intended(tasks), submitted(tasks), completed(tasks);
+
+    std::mt19937_64 gen(7);
+    std::exponential_distribution<double> gap(rate);
+    double offset = 0;
+    auto start = now_ns() + 1000000;
+    for (size_t i = 0; i < tasks; ++i) {
+        intended[i] = start + static_cast<int64_t>(offset * 1e9);
+        offset += poisson ? gap(gen) : 1.0 / rate;
+    }
+
+    for (size_t i = 0; i < tasks; ++i) {
+        auto now = now_ns();
+        if (intended[i] - now > 200000) std::this_thread::sleep_for(std::chrono::nanoseconds(intended[i] - now - 100000));
+        while ((now = now_ns()) < intended[i]) {
+        }
+        submitted[i] = now;
+        ex.submit([&completed, i, service_ns] {
+            spin_for(service_ns);
+            completed[i] = now_ns();
+        });
+    }
+    wait_all(ex);
+
+    result res;
+    res.target = rate;
+    int64_t last = 0;
+    for (size_t i = 0; i < tasks; ++i) {
+        res.corrected.record(completed[i] - intended[i]);
+        res.uncorrected.record(completed[i] - submitted[i]);
+        last = std::max(last, completed[i]);
+    }
+    res.achieved = tasks / ((last - intended[0]) / 1e9);
+    return res;
+}
+
+template <typename Executor>
+void sweep(std::ostream& out, const char* name, Executor& ex, int thread_nums, int64_t service_ns,
+           int64_t duration_ns, bool poisson) {
+    double capacity = thread_nums * 1e9 / service_ns;
+    uint64_t base_p99 = 0;
+    double knee = 0;
+    out << "{\"executor\":\"" << name << "\",\"capacity\":" << static_cast<uint64_t>(capacity) << ",\"points\":[";
+    for (int step = 1; step <= 15; ++step) {
+        auto res = run(ex, capacity * step / 10.0, poisson, service_ns, duration_ns);
+        auto p99 = res.corrected.percentile(99);
+        if (step == 1) base_p99 = p99;
+        // saturated: cannot keep up with the rate, or the tail blew up against light load
+        if (knee == 0 && (res.achieved < 0.95 * res.target || p99 > 10 * base_p99)) knee = res.target;
+        out << (step == 1 ? "\n" : ",\n") << "{\"target\":" << static_cast<uint64_t>(res.target)
+            << ",\"achieved\":" << static_cast<uint64_t>(res.achieved) << ",\"corrected_ns\":";
+        write_percentiles(out, res.corrected);
+        out << ",\"uncorrected_ns\":";
+        write_percentiles(out, res.uncorrected);
+        out << "}" << std::flush;
+    }
+    out << "\n],\"knee\":" << static_cast<uint64_t>(knee) << "}";
+}
+
+int main(int argn, char** argvs) {
+    int thread_nums, service_us, duration_ms;
+    if (argn >= 4 && argn <= 6) {
+        thread_nums = atoi(argvs[1]);
+        service_us = atoi(argvs[2]);
+        duration_ms = atoi(argvs[3]);
+    } else {
+        fprintf(stderr, "Invalid parameter! usage: [threads + service us + duration ms] (+ fixed|poisson) (+ output.json)\n");
+        return -1;
+    }
+    bool poisson = argn < 5 || std::string(argvs[4]) != "fixed";
+    std::ofstream file;
+    if (argn == 6) file.open(argvs[5]);
+    std::ostream& out = argn == 6 ? file : std::cout;
+    int64_t service_ns = service_us * 1000LL, duration_ns = duration_ms * 1000000LL;
+
+    out << "{\"benchmark\":\"open_loop\",\"arrival\":\"" << (poisson ? "poisson" : "fixed")
+        << "\",\"threads\":" << thread_nums << ",\"service_ns\":" << service_ns << ",\"results\":[\n";
+    {
+        wsp::workbranch br(thread_nums);
+        sweep(out, "workbranch", br, thread_nums, service_ns, duration_ns, poisson);
+    }
+    out << ",\n";
+    {
+        wsp::dynbranch br(1, thread_nums);
+        sweep(out, "dynbranch", br, thread_nums, service_ns, duration_ns, poisson);
+    }
+    out << ",\n";
+    {
+        wsp::workspace spc;
+        for (int i = 0; i < thread_nums; ++i) spc.attach(new wsp::workbranch(1));
+        sweep(out, "workspace", spc, thread_nums, service_ns, duration_ns, poisson);
+    }
+    out << "\n]}" << std::endl;
+}
@@ -0,0 +1,115 @@
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <workspace/workspace.hpp>
+
+#include "latency.h"
+
+// Supervisor reaction: drive a dynbranch with step, spike, ramp and sawtooth arrival patterns
+// and measure how fast it scales up, how deep the queue gets, how many thread-seconds it keeps
+// beyond the demand and how many threads it creates and destroys. A sampled time series is
+// included for plotting. Output: JSON.
+
+struct pattern {
+    const char* name;
+    std::function<double(double)> demand;  // offered load in workers, as a function of time (in phases)
+    double phases;                         // length of the pattern
+};
+
+struct sample {
+    double t_ms;
+    double demand;
+    size_t workers;
+    size_t queued;
+};
+
+int main(int argn, char** argvs) {
+    int max_workers, service_us, phase_ms, idle_ms = 100;
+    if (argn >= 4 && argn <= 6) {
+        max_workers = atoi(argvs[1]);
+        service_us = atoi(argvs[2]);
+        phase_ms = atoi(argvs[3]);
+        if (argn >= 5) idle_ms = atoi(argvs[4]);
+    } else {
+        fprintf(stderr, "Invalid parameter! usage: [max threads + service us + phase ms] (+ idle timeout ms) (+ output.json)\n");
+        return -1;
+    }
+    std::ofstream file;
+    if (argn == 6) file.open(argvs[5]);
+    std::ostream& out = argn == 6 ? file : std::cout;
+
+    double peak = 0.8 * max_workers;
+    std::vector<pattern> patterns = {
+        {"step", [=](double t) { return t < 1 ? 0.5 : t < 3 ? peak : 0.5; }, 4},
+        {"spike", [=](double t) { return t >= 1 && t < 1.2 ? 2.0 * max_workers : 0.5; }, 3},
+        {"ramp", [=](double t) { return t < 1 ? 0.5 : t < 3 ? 0.5 + (peak - 0.5) * (t - 1) / 2 : 0.5; }, 4},
+        {"sawtooth", [=](double t) { return t < 1 ? 0.5 : 0.5 + (peak - 0.5) * std::fmod(t - 1, 1.0); }, 4},
+    };
+
+    out << "{\"benchmark\":\"supervisor\",\"max_workers\":" << max_workers << ",\"service_ns\":" << service_us * 1000
+        << ",\"phase_ms\":" << phase_ms << ",\"idle_timeout_ms\":" << idle_ms << ",\"patterns\":[";
+    bool first = true;
+    for (auto& pat : patterns) {
+        wsp::dynbranch br(1, max_workers, wsp::waitstrategy::blocking, std::chrono::milliseconds(idle_ms));
+        auto before = br.stats();
+
+        int64_t service_ns = service_us * 1000LL, phase_ns = phase_ms * 1000000LL;
+        auto demand_at = [&](int64_t ns) { return pat.demand(static_cast<double>(ns) / phase_ns); };
+        auto length_ns = static_cast<int64_t>(pat.phases * phase_ns);
+
+        std::vector<sample> samples;
+        std::atomic_bool done{false};
+        auto start = now_ns();
+        std::thread sampler([&] {
+            while (!done.load()) {
+                auto t = now_ns() - start;
+                samples.push_back({t / 1e6, demand_at(t), br.num_workers(), br.num_tasks()});
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        // open-loop arrivals: the gap follows the current demand
+        for (int64_t next = start; next - start < length_ns;) {
+            auto now = now_ns();
+            if (next - now > 200000) std::this_thread::sleep_for(std::chrono::nanoseconds(next - now - 100000));
+            while (now_ns() < next) {
+            }
+            br.submit([service_ns] { spin_for(service_ns); });
+            next += static_cast<int64_t>(service_ns / demand_at(next - start));
+        }
+        br.wait_tasks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(phase_ms + 2 * idle_ms));  // let it scale down
+        done = true;
+        sampler.join();
+        auto after = br.stats();
+
+        // reaction: from the first time demand exceeds one worker to the workers covering the peak demand
+        double top = 0;
+        for (auto& s : samples) top = std::max(top, s.demand);
+        auto target = std::min<size_t>(max_workers, static_cast<size_t>(std::ceil(top)));
+        double rise = -1, scale_up = -1, over = 0;
+        size_t queue_peak = 0;
+        for (size_t i = 0; i < samples.size(); ++i) {
+            auto& s = samples[i];
+            if (rise < 0 && s.demand > 1) rise = s.t_ms;
+            if (rise >= 0 && scale_up < 0 && s.workers >= target) scale_up = s.t_ms - rise;
+            queue_peak = std::max(queue_peak, s.queued);
+            if (i > 0) {
+                auto need = std::min<double>(max_workers, std::ceil(s.demand));
+                over += std::max(0.0, s.workers - need) * (s.t_ms - samples[i - 1].t_ms) / 1000;
+            }
+        }
+
+        out << (first ? "\n" : ",\n") << "{\"pattern\":\"" << pat.name << "\",\"time_to_scale_up_ms\":" << scale_up
+            << ",\"queue_peak\":" << queue_peak << ",\"over_provisioned_thread_s\":" << over
+            << ",\"threads_created\":" << after.spawned - before.spawned
+            << ",\"threads_destroyed\":" << after.exited - before.exited << ",\"series\":[";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            auto& s = samples[i];
+            out << (i ? "," : "") << "[" << s.t_ms << "," << s.demand << "," << s.workers << "," << s.queued << "]";
+        }
+        out << "]}" << std::flush;
+        first = false;
+    }
+    out << "\n]}" << std::endl;
+}
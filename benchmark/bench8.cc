@@ -0,0 +1,106 @@
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <workspace/workspace.hpp>
+
+#include "perfcounters.h"
+#include "timewait.h"
+
+// Per-worker hardware counters: open cycles, instructions, cache misses and context switches on
+// every worker thread, submit empty tasks, and report the counters per branch and per task.
+// Counters that the system does not expose are printed as "n/a".
+
+// Collect the thread ids of the workers: every worker takes one task and holds it until all did
+template <typename Branch>
+std::vector<long> worker_ids(Branch& br, int workers) {
+    std::mutex lok;
+    std::condition_variable cv;
+    std::vector<long> tids;
+    for (int i = 0; i < workers; ++i) {
+        br.submit([&] {
+            std::unique_lock<std::mutex> lock(lok);
+            tids.push_back(perf_counters::thread_id());
+            cv.notify_all();
+            cv.wait(lock, [&] { return static_cast<int>(tids.size()) == workers; });
+        });
+    }
+    br.wait_tasks();
+    return tids;
+}
+
+void report(const char* name, int thread_nums, int task_nums, double time_cost, const perf_counters::values& sum) {
+    std::cout << std::left << std::setw(12) << name << " | threads: " << std::setw(2) << thread_nums
+              << " | tasks: " << task_nums << " | time-cost: " << time_cost << " (s)" << std::endl;
+    for (int i = 0; i < perf_counters::count; ++i) {
+        std::cout << "    " << std::setw(17) << perf_counters::name(i) << ": ";
+        if (sum.ok[i]) {
+            std::cout << std::setw(14) << sum.v[i] << " | per task: " << static_cast<double>(sum.v[i]) / task_nums;
+        } else {
+            std::cout << "n/a";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argn, char** argvs) {
+    int task_nums, thread_nums;
+    if (argn == 3) {
+        thread_nums = atoi(argvs[1]);
+        task_nums = atoi(argvs[2]);
+    } else {
+        fprintf(stderr, "Invalid parameter! usage: [threads + tasks]\n");
+        return -1;
+    }
+
+    // one branch with all the workers
+    {
+        wsp::workbranch wb(thread_nums, wsp::waitstrategy::balance);
+        std::vector<std::unique_ptr<perf_counters>> counters;
+        for (auto tid : worker_ids(wb, thread_nums)) counters.emplace_back(new perf_counters(tid));
+        if (!counters.front()->available()) {
+            std::cerr << "perf_event_open unavailable (check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+        }
+
+        for (auto& each : counters) each->start();
+        auto time_cost = timewait([&] {
+            for (int i = 0; i < task_nums; ++i) {
+                wb.submit([] {});
+            }
+            wb.wait_tasks();
+        });
+        perf_counters::values sum;
+        for (auto& each : counters) sum += each->stop();
+        report("workbranch", thread_nums, task_nums, time_cost, sum);
+    }
+
+    // workspace dispatching to single-worker branches
+    {
+        wsp::workspace spc;
+        std::vector<std::unique_ptr<perf_counters>> counters;
+        std::vector<wsp::workbranch*> branches;
+        std::vector<uint64_t> done;
+        for (int i = 0; i < thread_nums; ++i) {
+            auto id = spc.attach(new wsp::workbranch(1, wsp::waitstrategy::balance));
+            branches.push_back(&spc[id]);
+            counters.emplace_back(new perf_counters(worker_ids(spc[id], 1).front()));
+            done.push_back(spc[id].stats().completed);
+        }
+
+        for (auto& each : counters) each->start();
+        auto time_cost = timewait([&] {
+            for (int i = 0; i < task_nums / 10; ++i) {
+                spc.submit<wsp::task::seq>([] {}, [] {}, [] {}, [] {}, [] {}, [] {}, [] {}, [] {}, [] {}, [] {});
+            }
+            spc.for_each([](wsp::workbranch& each) { each.wait_tasks(); });
+        });
+        perf_counters::values sum;
+        for (size_t i = 0; i < counters.size(); ++i) {
+            auto each = counters[i]->stop();
+            auto tasks = static_cast<int>(branches[i]->stats().completed - done[i]) * 10;  // a sequence counts once
+            report(("  branch " + std::to_string(i)).c_str(), 1, tasks, time_cost, each);
+            sum += each;
+        }
+        report("workspace", thread_nums, task_nums, time_cost, sum);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <workspace/workspace.hpp>
+
+/**
+ * Helpers shared by the latency benchmarks
+ */
+
+using bench_clock = std::chrono::steady_clock;
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now().time_since_epoch()).count();
+}
+
+// Burn the CPU for about ns nanoseconds
+static inline void spin_for(int64_t ns) {
+    auto until = now_ns() + ns;
+    while (now_ns() < until) {
+    }
+}
+
+static inline const char* strategy_name(wsp::waitstrategy strategy) {
+    switch (strategy) {
+        case wsp::waitstrategy::lowlatancy:
+            return "lowlatancy";
+        case wsp::waitstrategy::balance:
+            return "balance";
+        case wsp::waitstrategy::blocking:
+            return "blocking";
+    }
+    return "";
+}
+
+// {"count":..,"mean":..,"p50":..,"p99":..,"p999":..,"max":..}
+static inline void write_percentiles(std::ostream& os, const wsp::histogram_snapshot& hist) {
+    os << "{\"count\":" << hist.count() << ",\"mean\":" << static_cast<uint64_t>(hist.mean())
+       << ",\"p50\":" << hist.percentile(50) << ",\"p99\":" << hist.percentile(99)
+       << ",\"p999\":" << hist.percentile(99.9) << ",\"max\":" << hist.max() << "}";
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Hardware/software counters of one thread via perf_event_open (Linux only)
+ * Counters that cannot be opened (no PMU, perf_event_paranoid, containers, other OS)
+ * stay unavailable and read as 0 instead of failing the benchmark.
+ */
+class perf_counters {
+public:
+    enum { cycles, instructions, cache_misses, context_switches, count };
+
+    struct values {
+        std::array<uint64_t, count> v{};
+        std::array<bool, count> ok{};
+
+        values& operator+=(const values& other) {
+            for (int i = 0; i < count; ++i) {
+                v[i] += other.v[i];
+                ok[i] = ok[i] || other.ok[i];
+            }
+            return *this;
+        }
+    };
+
+    static const char* name(int idx) {
+        static const char* names[count] = {"cycles", "instructions", "cache_misses", "context_switches"};
+        return names[idx];
+    }
+
+    // id of the calling thread, as perf_event_open expects it
+    static long thread_id() {
+#if defined(__linux__)
+        return syscall(SYS_gettid);
+#else
+        return 0;
+#endif
+    }
+
+    explicit perf_counters(long tid) {
+        fds.fill(-1);
+#if defined(__linux__)
+        const std::pair<uint32_t, uint64_t> events[count] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+        };
+        for (int i = 0; i < count; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = events[i].first == PERF_TYPE_HARDWARE;  // allowed at perf_event_paranoid <= 2
+            attr.exclude_hv = 1;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+        }
+#else
+        (void)tid;
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters() {
+#if defined(__linux__)
+        for (auto fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    bool available() const {
+        for (auto fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (auto fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    values stop() {
+        values res;
+#if defined(__linux__)
+        for (int i = 0; i < count; ++i) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t v = 0;
+            if (read(fds[i], &v, sizeof(v)) == sizeof(v)) {
+                res.v[i] = v;
+                res.ok[i] = true;
+            }
+        }
+#endif
+        return res;
+    }
+
+private:
+    std::array<int, count> fds;
+};
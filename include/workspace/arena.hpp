@@ -0,0 +1,240 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// std::pmr is only used when the standard library provides it (C++17)
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define WSP_HAS_PMR 1
+#endif
+#endif
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Counters of one or several worker arenas
+ */
+struct arena_stats {
+    uint64_t allocated = 0;  // bytes handed out
+    uint64_t blocks = 0;     // blocks taken from the heap
+    uint64_t resets = 0;     // times the arena was rewound
+    size_t peak = 0;         // largest use between two resets (bytes)
+    size_t retained = 0;     // bytes kept for the next tasks
+};
+
+/**
+ * @brief Monotonic scratch memory owned by one worker
+ *
+ * Allocation bumps a pointer inside a block, deallocation does nothing. The worker rewinds the arena
+ * after each task, keeping up to `retain` bytes of blocks so that steady-state tasks never reach the
+ * heap. With C++17 it is a std::pmr::memory_resource, usable with std::pmr containers.
+ * @note memory from the arena is valid until the current task returns; only the owning thread may
+ * allocate, collect() may be called from anywhere.
+ */
+class worker_arena
+#if defined(WSP_HAS_PMR)
+  : public std::pmr::memory_resource
+#endif
+{
+    struct block {
+        block* next;
+        size_t size;  // usable bytes after the header
+    };
+    constexpr static size_t header =
+        (sizeof(block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    block* used = nullptr;   // blocks of the current interval, newest first
+    block* spare = nullptr;  // blocks kept from earlier intervals
+    char* cur = nullptr;
+    char* end = nullptr;
+    size_t in_use = 0;  // bytes handed out since the last reset
+
+    std::atomic_size_t block_size{64 * 1024};
+    std::atomic_size_t retain{1024 * 1024};
+
+    std::atomic<uint64_t> allocated{0};
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> resets{0};
+    std::atomic_size_t peak{0};
+    std::atomic_size_t held{0};  // bytes of all blocks
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static char* data(block* b) {
+        return reinterpret_cast<char*>(b) + header;
+    }
+
+    static worker_arena*& local() {
+        thread_local worker_arena* arena = nullptr;
+        return arena;
+    }
+
+    void use(block* b) {
+        b->next = used;
+        used = b;
+        cur = data(b);
+        end = cur + b->size;
+    }
+
+    void* refill(size_t bytes, size_t align) {
+        auto need = bytes + align;
+        if (spare && spare->size >= need) {
+            auto b = spare;
+            spare = b->next;
+            use(b);
+        } else {
+            auto size = std::max(block_size.load(std::memory_order_relaxed), need);
+            use(new (::operator new(header + size)) block{nullptr, size});
+            held.store(held.load(std::memory_order_relaxed) + header + size, std::memory_order_relaxed);
+            bump(blocks, 1);
+        }
+        return take(bytes, align);
+    }
+
+    void* take(size_t bytes, size_t align) {
+        auto addr = reinterpret_cast<uintptr_t>(cur);
+        auto aligned = (addr + align - 1) & ~(uintptr_t(align) - 1);
+        if (!cur || aligned + bytes > reinterpret_cast<uintptr_t>(end)) return nullptr;
+        cur = reinterpret_cast<char*>(aligned + bytes);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // free the first block of a list
+    void drop(block*& list) {
+        auto next = list->next;
+        held.store(held.load(std::memory_order_relaxed) - header - list->size, std::memory_order_relaxed);
+        ::operator delete(list);
+        list = next;
+    }
+
+public:
+    worker_arena() = default;
+    worker_arena(const worker_arena&) = delete;
+    worker_arena& operator=(const worker_arena&) = delete;
+
+    ~worker_arena() {
+        release();
+    }
+
+    // bind an arena to the calling thread while alive
+    class scope {
+        worker_arena* prev;
+
+    public:
+        explicit scope(worker_arena* arena)
+          : prev(local()) {
+            local() = arena;
+        }
+        ~scope() {
+            local() = prev;
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+    /**
+     * @brief arena bound to the calling thread
+     * @return the worker's arena, or nullptr outside a worker
+     */
+    static worker_arena* current() {
+        return local();
+    }
+
+    /**
+     * @brief allocate scratch memory
+     * @param bytes size
+     * @param align alignment (power of two)
+     * @return memory valid until the next reset
+     */
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        auto p = take(bytes, align);
+        if (!p) p = refill(bytes, align);
+        in_use += bytes;
+        bump(allocated, bytes);
+        return p;
+    }
+
+    // memory is reclaimed at reset
+    void deallocate(void*, size_t, size_t = alignof(std::max_align_t)) {
+    }
+
+    /**
+     * @brief rewind the arena, keeping up to the retained size of blocks
+     * @note the worker calls it after every task; a no-op when nothing was allocated
+     */
+    void reset() {
+        if (!used) return;
+        if (in_use > peak.load(std::memory_order_relaxed)) peak.store(in_use, std::memory_order_relaxed);
+        in_use = 0;
+        while (used) {
+            auto next = used->next;
+            used->next = spare;
+            spare = used;
+            used = next;
+        }
+        cur = end = nullptr;
+        auto limit = retain.load(std::memory_order_relaxed);
+        while (spare && held.load(std::memory_order_relaxed) > limit) drop(spare);
+        bump(resets, 1);
+    }
+
+    /**
+     * @brief give every block back to the heap
+     */
+    void release() {
+        while (used) drop(used);
+        while (spare) drop(spare);
+        cur = end = nullptr;
+        in_use = 0;
+    }
+
+    // clear the counters for a new worker (only while nobody allocates)
+    void reset_stats() {
+        allocated.store(0, std::memory_order_relaxed);
+        blocks.store(0, std::memory_order_relaxed);
+        resets.store(0, std::memory_order_relaxed);
+        peak.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief set the block size and how many bytes are kept between resets
+     * @note may be called from any thread, applies to the next block and the next reset
+     */
+    void set_limits(size_t block_bytes, size_t retain_bytes) {
+        block_size.store(std::max<size_t>(block_bytes, 256), std::memory_order_relaxed);
+        retain.store(retain_bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief add the counters into st
+     */
+    void collect(arena_stats& st) const {
+        st.allocated += allocated.load(std::memory_order_relaxed);
+        st.blocks += blocks.load(std::memory_order_relaxed);
+        st.resets += resets.load(std::memory_order_relaxed);
+        st.peak = std::max(st.peak, peak.load(std::memory_order_relaxed));
+        st.retained += held.load(std::memory_order_relaxed);
+    }
+
+#if defined(WSP_HAS_PMR)
+private:
+    void* do_allocate(size_t bytes, size_t align) override {
+        return allocate(bytes, align);
+    }
+    void do_deallocate(void*, size_t, size_t) override {
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+#endif
+};
+
+}  // namespace details
+}  // namespace wsp
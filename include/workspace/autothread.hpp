@@ -2,20 +2,10 @@
 #include <atomic>
 #include <thread>
 
-
-#if defined(_WIN32)
-#include <windows.h>
-#elif defined(__unix__)
-#include <errno.h>  // for errno
-#include <pthread.h>
-#include <signal.h>  // for ESRCH
-#endif
-
 namespace wsp {
 namespace details {
 class autothread {
     std::thread thrd;
-    std::atomic_bool detach = false;
 
 public:
     autothread() noexcept = default;
@@ -30,9 +20,16 @@ public:
     }
     autothread(const autothread& other) = delete;
     autothread(autothread&& other) = default;
+
+    // start over with another thread (the current one, if any, is detached)
+    autothread& operator=(std::thread&& t) {
+        if (thrd.joinable()) thrd.detach();
+        thrd = std::move(t);
+        return *this;
+    }
+
     ~autothread() {
         if (thrd.joinable()) thrd.detach();
-        detach = true;
     }
 
     using id = std::thread::id;
@@ -40,18 +37,9 @@ public:
         return thrd.get_id();
     }
 
-    bool is_alive() {
-        if (detach) return false;
-        if (thrd.joinable()) {
-            auto handle = thrd.native_handle();
-#if defined(_WIN32)
-            DWORD waitResult = WaitForSingleObject(handle, 0);
-            return waitResult == WAIT_TIMEOUT;
-#else
-            return pthread_kill(handle, 0) == 0;
-#endif
-        }
-        return false;
+    // wait for the thread to finish (a no-op if there is none, or if called from the thread itself)
+    void join() {
+        if (thrd.joinable() && thrd.get_id() != std::this_thread::get_id()) thrd.join();
     }
 };
 
@@ -0,0 +1,305 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+namespace details {
+
+// wakes a selector blocked on several channels
+struct channel_waiter {
+    std::mutex lok;
+    std::condition_variable cv;
+    bool ready = false;
+
+    void notify() {
+        std::lock_guard<std::mutex> lock(lok);
+        ready = true;
+        cv.notify_one();
+    }
+};
+
+/**
+ * @brief MPMC queue between tasks, bounded or unbounded, with close semantics
+ *
+ * A task that has to wait (recv on an empty channel, send on a full one) first spins briefly, then
+ * waits inside a blocking_region: its workbranch starts a compensating worker for the time it waits,
+ * so producers queued on the same branch still run and the branch cannot deadlock on the channel.
+ * Once the branch is at its cap (see workbranch::set_max_compensating) further waiters keep their
+ * worker busy instead: they poll the channel and run the branch's queued tasks meanwhile.
+ * @note Helping nests the queued task on the waiter's stack, so it is the fallback only: a nested
+ * producer blocked on a full channel could only be freed by the consumer it is nested in.
+ * @tparam T item type (movable)
+ */
+template <typename T>
+class channel {
+    constexpr static int spin_limit = 32;
+
+    std::mutex lok;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> items;
+    size_t cap;
+    bool closed = false;
+    std::vector<channel_waiter*> waiters;  // selectors waiting for an item or close
+
+public:
+    constexpr static size_t unbounded = 0;
+
+    /**
+     * @param capacity maximum number of queued items (unbounded by default)
+     */
+    explicit channel(size_t capacity = unbounded)
+      : cap(capacity) {
+    }
+
+    channel(const channel&) = delete;
+    channel& operator=(const channel&) = delete;
+
+    /**
+     * @brief queue an item, waiting while the channel is full
+     * @return false if the channel is closed (the item is dropped)
+     */
+    bool send(T item) {
+        std::unique_lock<std::mutex> lock(lok);
+        wait(lock, not_full, [this] { return closed || !full(); });
+        if (closed) return false;
+        push(lock, std::move(item));
+        return true;
+    }
+
+    /**
+     * @brief queue an item if there is room
+     * @return false if the channel is full or closed
+     */
+    bool try_send(T item) {
+        std::unique_lock<std::mutex> lock(lok);
+        if (closed || full()) return false;
+        push(lock, std::move(item));
+        return true;
+    }
+
+    /**
+     * @brief take an item, waiting while the channel is empty
+     * @param out receives the item
+     * @return false once the channel is closed and drained
+     */
+    bool recv(T& out) {
+        std::unique_lock<std::mutex> lock(lok);
+        wait(lock, not_empty, [this] { return closed || !items.empty(); });
+        return pop(lock, out);
+    }
+
+    /**
+     * @brief take an item if there is one
+     * @return false if the channel is empty
+     */
+    bool try_recv(T& out) {
+        std::unique_lock<std::mutex> lock(lok);
+        return pop(lock, out);
+    }
+
+    /**
+     * @brief refuse new items and wake every waiter; queued items can still be received
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            closed = true;
+            for (auto w : waiters) w->notify();
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    /**
+     * @brief true once closed and drained: recv would return false right away
+     */
+    bool is_drained() {
+        std::lock_guard<std::mutex> lock(lok);
+        return closed && items.empty();
+    }
+
+    bool is_closed() {
+        std::lock_guard<std::mutex> lock(lok);
+        return closed;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(lok);
+        return items.size();
+    }
+
+    // selectors register while they wait
+    void subscribe(channel_waiter* w) {
+        std::lock_guard<std::mutex> lock(lok);
+        waiters.push_back(w);
+    }
+
+    void unsubscribe(channel_waiter* w) {
+        std::lock_guard<std::mutex> lock(lok);
+        waiters.erase(std::remove(waiters.begin(), waiters.end(), w), waiters.end());
+    }
+
+private:
+    bool full() const {
+        return cap != unbounded && items.size() >= cap;
+    }
+
+    void push(std::unique_lock<std::mutex>& lock, T&& item) {
+        items.push_back(std::move(item));
+        for (auto w : waiters) w->notify();  // under the lock: a waiter leaves only after unsubscribe
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    bool pop(std::unique_lock<std::mutex>& lock, T& out) {
+        if (items.empty()) return false;
+        out = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    // spin a little, then wait lending the worker to the branch (see lend_until)
+    template <typename Pred>
+    void wait(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, Pred ready) {
+        for (int i = 0; i < spin_limit && !ready(); ++i) {
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+        while (!ready()) {  // another task may have taken the slot or item between unlock and relock
+            lock.unlock();
+            lend_until(
+                [this, &ready] {
+                    std::lock_guard<std::mutex> relock(lok);
+                    return ready();
+                },
+                [this, &cv, &ready] {
+                    std::unique_lock<std::mutex> relock(lok);
+                    cv.wait(relock, ready);
+                });
+            lock.lock();
+        }
+    }
+};
+
+/**
+ * @brief Receive from whichever of several channels is ready first
+ *
+ * Register a handler per channel with on(), then call wait() (or try_once()) as many times as
+ * needed. Channels are polled round-robin so that a busy channel cannot starve the others.
+ */
+class selector {
+    struct case_base {
+        virtual ~case_base() = default;
+        virtual bool try_take() = 0;  // receive and run the handler if an item is there
+        virtual bool drained() = 0;
+        virtual void subscribe(channel_waiter* w) = 0;
+        virtual void unsubscribe(channel_waiter* w) = 0;
+    };
+
+    template <typename T, typename F>
+    struct case_impl : case_base {
+        channel<T>& ch;
+        F handler;
+
+        case_impl(channel<T>& c, F&& f)
+          : ch(c)
+          , handler(std::move(f)) {
+        }
+        bool try_take() override {
+            T item;
+            if (!ch.try_recv(item)) return false;
+            handler(std::move(item));
+            return true;
+        }
+        bool drained() override {
+            return ch.is_drained();
+        }
+        void subscribe(channel_waiter* w) override {
+            ch.subscribe(w);
+        }
+        void unsubscribe(channel_waiter* w) override {
+            ch.unsubscribe(w);
+        }
+    };
+
+    constexpr static int spin_limit = 32;
+
+    std::vector<std::unique_ptr<case_base>> cases;
+    size_t start = 0;  // first channel polled next time
+
+public:
+    /**
+     * @brief add a channel
+     * @param ch channel to receive from
+     * @param handler <void(T)> called with the received item
+     */
+    template <typename T, typename F>
+    selector& on(channel<T>& ch, F handler) {
+        cases.emplace_back(new case_impl<T, F>(ch, std::move(handler)));
+        return *this;
+    }
+
+    /**
+     * @brief receive one item from a ready channel, without waiting
+     * @return false if no channel has an item
+     */
+    bool try_once() {
+        for (size_t i = 0; i < cases.size(); ++i) {
+            auto idx = (start + i) % cases.size();
+            if (cases[idx]->try_take()) {
+                start = idx + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief receive one item, waiting until a channel has one
+     * @return false once every channel is closed and drained
+     * @note waits like channel::recv: lends the worker to a compensating one, or helps past the cap
+     */
+    bool wait() {
+        for (int i = 0; i < spin_limit; ++i) {
+            if (try_once()) return true;
+            std::this_thread::yield();
+        }
+        channel_waiter waiter;
+        for (auto& c : cases) c->subscribe(&waiter);
+        bool got = false;
+        auto ready = [this, &got] {
+            got = try_once();
+            return got || all_drained();
+        };
+        lend_until(ready, [&waiter, &ready] {
+            while (!ready()) {
+                std::unique_lock<std::mutex> lock(waiter.lok);
+                waiter.cv.wait(lock, [&waiter] { return waiter.ready; });
+                waiter.ready = false;
+            }
+        });
+        for (auto& c : cases) c->unsubscribe(&waiter);
+        return got;
+    }
+
+private:
+    bool all_drained() {
+        for (auto& c : cases) {
+            if (!c->drained()) return false;
+        }
+        return true;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
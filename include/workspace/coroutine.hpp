@@ -0,0 +1,454 @@
+#pragma once
+
+// C++20 coroutine support, compiled only when the compiler and the standard library provide it
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define WSP_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(WSP_HAS_COROUTINES)
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <workspace/errors.hpp>
+#include <workspace/invoke.hpp>
+#include <workspace/utility.hpp>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Recycles coroutine frames by size class
+ *
+ * Every workbranch owns one and binds it to its workers, so frames created on a worker come from
+ * (and go back to) that branch's pool instead of the global heap. Frames created elsewhere, and
+ * frames larger than the biggest class, use plain operator new.
+ * @note A frame may be freed on another branch than the one that allocated it: blocks are plain
+ * operator new memory, so any pool can adopt them.
+ */
+class frame_pool {
+    constexpr static size_t granularity = 64;
+    constexpr static size_t classes = 16;      // frames up to 1 KiB are pooled
+    constexpr static size_t max_cached = 256;  // blocks kept per class
+
+    struct bucket {
+        std::mutex lok;
+        std::vector<void*> blocks;
+    };
+    bucket buckets[classes];
+
+    static frame_pool*& local() {
+        thread_local frame_pool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t class_of(size_t size) {
+        return (size + granularity - 1) / granularity - 1;
+    }
+
+public:
+    frame_pool() = default;
+    frame_pool(const frame_pool&) = delete;
+    frame_pool& operator=(const frame_pool&) = delete;
+
+    ~frame_pool() {
+        for (auto& b : buckets) {
+            for (auto p : b.blocks) ::operator delete(p);
+        }
+    }
+
+    // bind a pool to the calling thread while alive
+    class scope {
+        frame_pool* prev;
+
+    public:
+        explicit scope(frame_pool* pool)
+          : prev(local()) {
+            local() = pool;
+        }
+        ~scope() {
+            local() = prev;
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+    static void* allocate(size_t size) {
+        auto pool = local();
+        auto idx = class_of(size);
+        if (pool && idx < classes) {
+            auto& b = pool->buckets[idx];
+            {
+                std::lock_guard<std::mutex> lock(b.lok);
+                if (!b.blocks.empty()) {
+                    auto p = b.blocks.back();
+                    b.blocks.pop_back();
+                    return p;
+                }
+            }
+            return ::operator new((idx + 1) * granularity);
+        }
+        return ::operator new(idx < classes ? (idx + 1) * granularity : size);
+    }
+
+    static void deallocate(void* p, size_t size) {
+        auto pool = local();
+        auto idx = class_of(size);
+        if (pool && idx < classes) {
+            auto& b = pool->buckets[idx];
+            std::lock_guard<std::mutex> lock(b.lok);
+            if (b.blocks.size() < max_cached) {
+                b.blocks.push_back(p);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+};
+
+template <typename T>
+class co_task;
+
+// shared part of every task promise
+struct task_promise_base {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    struct final_awaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            auto next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {
+        }
+    };
+
+    static void* operator new(size_t size) {
+        return frame_pool::allocate(size);
+    }
+    static void operator delete(void* p, size_t size) {
+        frame_pool::deallocate(p, size);
+    }
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+    final_awaiter final_suspend() const noexcept {
+        return {};
+    }
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+};
+
+template <typename T>
+struct task_promise : task_promise_base {
+    std::optional<T> value;
+
+    co_task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct task_promise<void> : task_promise_base {
+    co_task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {
+    }
+
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+/**
+ * @brief Lazy coroutine producing a T
+ *
+ * Nothing runs until the task is awaited (or handed to spawn / sync_wait). The awaiting coroutine
+ * resumes on whatever thread the task finishes on; use schedule() / resume_on() to move between
+ * branches. An exception escaping the body is rethrown to the awaiter.
+ * @tparam T result type
+ */
+template <typename T = void>
+class co_task {
+public:
+    using promise_type = task_promise<T>;
+
+private:
+    std::coroutine_handle<promise_type> h;
+
+public:
+    explicit co_task(std::coroutine_handle<promise_type> handle) noexcept
+      : h(handle) {
+    }
+    co_task(co_task&& other) noexcept
+      : h(std::exchange(other.h, nullptr)) {
+    }
+    co_task& operator=(co_task&& other) noexcept {
+        if (this != &other) {
+            if (h) h.destroy();
+            h = std::exchange(other.h, nullptr);
+        }
+        return *this;
+    }
+    co_task(const co_task&) = delete;
+    co_task& operator=(const co_task&) = delete;
+
+    ~co_task() {
+        if (h) h.destroy();
+    }
+
+    auto operator co_await() && noexcept {
+        struct awaiter {
+            std::coroutine_handle<promise_type> h;
+            bool await_ready() const noexcept {
+                return !h || h.done();
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                h.promise().continuation = caller;
+                return h;  // start the task; it transfers back to the caller when done
+            }
+            T await_resume() {
+                return h.promise().result();
+            }
+        };
+        return awaiter{h};
+    }
+};
+
+template <typename T>
+inline co_task<T> task_promise<T>::get_return_object() noexcept {
+    return co_task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline co_task<void> task_promise<void>::get_return_object() noexcept {
+    return co_task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+/**
+ * @brief Resumes a suspended coroutine exactly once
+ *
+ * Shared by the task submitted to resume it and every copy of that task. If the executor drops the
+ * task without running it (discard/cancel shutdown), the last copy resumes the coroutine on the
+ * dropping thread with task_cancelled, so its frame unwinds instead of leaking. Executors destroy
+ * dropped tasks outside their locks, so the unwinding coroutine may submit again.
+ */
+class resume_ticket {
+    std::coroutine_handle<> h;
+    std::exception_ptr& error;  // rethrown by the awaiter when resumed
+    bool resumed = false;
+
+public:
+    resume_ticket(std::coroutine_handle<> handle, std::exception_ptr& err)
+      : h(handle)
+      , error(err) {
+    }
+    resume_ticket(const resume_ticket&) = delete;
+    resume_ticket& operator=(const resume_ticket&) = delete;
+
+    ~resume_ticket() {
+        if (resumed) return;
+        error = std::make_exception_ptr(task_cancelled());
+        h.resume();
+    }
+
+    void resume() {
+        resumed = true;
+        h.resume();
+    }
+};
+
+/**
+ * @brief Awaitable that resumes the coroutine as a task of an executor
+ * @note if the executor drops the task, co_await throws task_cancelled
+ */
+template <typename Executor>
+struct schedule_awaiter {
+    Executor& ex;
+    std::exception_ptr error;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+        auto ticket = std::make_shared<resume_ticket>(h, error);
+        ex.submit([ticket] { ticket->resume(); });
+    }
+    void await_resume() const {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+/**
+ * @brief Awaitable that runs a callable on an executor and resumes the coroutine with its result
+ * @note the coroutine continues on the worker that ran the callable, no thread blocks meanwhile; if the
+ * executor drops the task, co_await throws task_cancelled
+ */
+template <typename Executor, typename F, typename R = result_of_t<F>>
+class submit_awaiter {
+    using value_t = typename std::conditional<std::is_void<R>::value, char, R>::type;
+
+    Executor& ex;
+    F fn;
+    std::optional<value_t> value;
+    std::exception_ptr error;
+
+public:
+    submit_awaiter(Executor& executor, F&& f)
+      : ex(executor)
+      , fn(std::move(f)) {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+        auto ticket = std::make_shared<resume_ticket>(h, error);
+        ex.submit([this, ticket] {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    fn();
+                } else {
+                    value.emplace(fn());
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            ticket->resume();
+        });
+    }
+    R await_resume() {
+        if (error) std::rethrow_exception(error);
+        if constexpr (!std::is_void<R>::value) return std::move(*value);
+    }
+};
+
+// runs submitted callables on the calling thread
+struct inline_executor {
+    template <typename F>
+    void submit(F&& f) {
+        f();
+    }
+};
+
+// fire-and-forget coroutine that drives a co_task to a std::promise
+struct task_driver {
+    struct promise_type {
+        static void* operator new(size_t size) {
+            return frame_pool::allocate(size);
+        }
+        static void operator delete(void* p, size_t size) {
+            frame_pool::deallocate(p, size);
+        }
+        task_driver get_return_object() const noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() const noexcept {
+        }
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+template <typename Executor, typename T>
+task_driver drive(Executor* ex, co_task<T> t, std::promise<T> done) {
+    try {
+        if (ex) co_await schedule_awaiter<Executor>{*ex};
+        if constexpr (std::is_void<T>::value) {
+            co_await std::move(t);
+            done.set_value();
+        } else {
+            done.set_value(co_await std::move(t));
+        }
+    } catch (...) {
+        done.set_exception(std::current_exception());
+    }
+}
+
+}  // namespace details
+
+/**
+ * @brief suspend the coroutine and resume it on an executor
+ * @param ex workbranch, dynbranch or workspace
+ * @return awaitable
+ */
+template <typename Executor>
+details::schedule_awaiter<Executor> resume_on(Executor& ex) {
+    return {ex};
+}
+
+/**
+ * @brief run a callable on an executor without blocking the awaiting coroutine
+ * @param ex workbranch, dynbranch or workspace
+ * @param task callable object
+ * @param args arguments for the callable
+ * @return awaitable producing the callable's result (or rethrowing its exception)
+ */
+template <typename Executor, typename F, typename... Args>
+auto async_submit(Executor& ex, F&& task, Args&&... args) {
+    auto fn = [func = std::forward<F>(task), args_tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        return invoke_hpp::apply(func, args_tuple);
+    };
+    return details::submit_awaiter<Executor, decltype(fn)>(ex, std::move(fn));
+}
+
+/**
+ * @brief start a task on an executor
+ * @param ex workbranch, dynbranch or workspace
+ * @param t task to run
+ * @return std::future<T> receiving the task's result or exception
+ */
+template <typename Executor, typename T>
+std::future<T> spawn(Executor& ex, details::co_task<T> t) {
+    std::promise<T> done;
+    auto res = done.get_future();
+    details::drive(&ex, std::move(t), std::move(done));
+    return res;
+}
+
+/**
+ * @brief run a task from a non-coroutine context and wait for its result
+ * @param t task to run (starts on the calling thread)
+ * @return the task's result
+ * @note do not call it on a worker of a branch the task needs, that worker would be blocked
+ */
+template <typename T>
+T sync_wait(details::co_task<T> t) {
+    std::promise<T> done;
+    auto res = done.get_future();
+    details::drive<details::inline_executor>(nullptr, std::move(t), std::move(done));
+    return res.get();
+}
+
+}  // namespace wsp
+
+#endif  // WSP_HAS_COROUTINES
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+
+enum class dispatch {
+    adjacent,      // Compare the branch under the cursor with the next one and pick the shorter queue.
+    round_robin,   // Strict rotation over all branches.
+    power_of_two,  // Sample two random branches and pick the shorter queue.
+    least_loaded   // Scan every branch and pick the shortest queue.
+};
+
+namespace details {
+
+// xorshift64*, one state per thread
+inline uint64_t fast_rand() {
+    thread_local uint64_t state =
+        static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) ^
+        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ 0x9E3779B97F4A7C15ull;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * @brief Pick a workbranch for every task submitted to a workspace
+ * @note All built-in policies read queue lengths without locking and advance the cursor atomically,
+ * so pick() may be called from several threads at once.
+ */
+class dispatcher {
+public:
+    // user-supplied policy: return the index of the branch to use (taken modulo the number of branches)
+    using policy_fn = std::function<size_t(const std::vector<workbranch*>&)>;
+
+private:
+    dispatch mode;
+    policy_fn policy;
+    std::atomic_size_t cursor{0};
+
+public:
+    explicit dispatcher(dispatch how = dispatch::adjacent)
+      : mode(how) {
+    }
+
+    explicit dispatcher(policy_fn fn)
+      : mode(dispatch::adjacent)
+      , policy(std::move(fn)) {
+    }
+
+    /**
+     * @brief choose a branch
+     * @param brs candidates (not empty)
+     * @return the chosen branch
+     */
+    workbranch* pick(const std::vector<workbranch*>& brs) {
+        assert(!brs.empty());
+        auto n = brs.size();
+        if (n == 1) return brs.front();
+        if (policy) return brs[policy(brs) % n];
+
+        switch (mode) {
+            case dispatch::round_robin: {
+                return brs[cursor.fetch_add(1, std::memory_order_relaxed) % n];
+            }
+            case dispatch::power_of_two: {
+                auto r = fast_rand();
+                auto a = brs[r % n];
+                auto b = brs[(r % n + 1 + (r / n) % (n - 1)) % n];  // never equal to a
+                return b->num_tasks() < a->num_tasks() ? b : a;
+            }
+            case dispatch::least_loaded: {
+                // start from a rotating offset so ties are spread over all branches
+                auto first = cursor.fetch_add(1, std::memory_order_relaxed);
+                auto best = brs[first % n];
+                auto best_len = best->num_tasks();
+                for (size_t i = 1; i < n && best_len > 0; ++i) {
+                    auto each = brs[(first + i) % n];
+                    auto len = each->num_tasks();
+                    if (len < best_len) {
+                        best = each;
+                        best_len = len;
+                    }
+                }
+                return best;
+            }
+            case dispatch::adjacent:
+            default: {
+                auto pos = cursor.fetch_add(1, std::memory_order_relaxed);
+                auto this_br = brs[pos % n];
+                auto next_br = brs[(pos + 1) % n];
+                return next_br->num_tasks() < this_br->num_tasks() ? next_br : this_br;
+            }
+        }
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
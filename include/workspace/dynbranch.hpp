@@ -2,6 +2,7 @@
 #include <memory>
 
 #include "supervisor.hpp"
+#include "topology.hpp"
 #include "workbranch.hpp"
 
 namespace wsp {
@@ -32,20 +33,20 @@ public:
      * @param idle_timeout timeout (ms) for idle worker detection
      * @param time_interval interval (ms) between supervision checks
      */
-    explicit dynbranch(int min_workers = 1, int max_workers = std::max(2u, std::thread::hardware_concurrency()),
+    explicit dynbranch(int min_workers = 1, int max_workers = std::max(2u, topology::effective_cores()),
                        waitstrategy strategy = waitstrategy::blocking,
                        std::chrono::milliseconds idle_timeout = default_time_idle,
                        std::chrono::milliseconds time_interval = default_time_interval)
       : branch(std::make_shared<details::workbranch>(1, strategy))
       , supervisor(std::make_unique<details::supervisor>(idle_timeout, time_interval)) {
-        supervisor->supervise(branch, min_workers, max_workers);
+        supervisor->supervise(branch, min_workers, max_workers, idle_timeout);
     }
 
     /**
      * @brief construct a dynbranch using CPU-core-multiplied worker limits.
      *
-     * @param min_core_mult    Minimum thread count = core count × min_core_mult.
-     * @param max_core_mult    Maximum thread count = core count × max_core_mult.
+     * @param min_core_mult    Minimum thread count = effective core count × min_core_mult.
+     * @param max_core_mult    Maximum thread count = effective core count × max_core_mult.
      * @param strategy         Wait strategy.
      * @param idle_timeout timeout (ms) for idle worker detection
      * @param time_interval interval (ms) between supervision checks
@@ -56,7 +57,7 @@ public:
               std::chrono::milliseconds time_interval = default_time_interval)
       : branch(std::make_shared<details::workbranch>(1, strategy))
       , supervisor(std::make_unique<details::supervisor>(idle_timeout, time_interval)) {
-        supervisor->supervise(branch, cpu_multiple_tag, min_core_mult, max_core_mult, time_interval);
+        supervisor->supervise(branch, cpu_multiple_tag, min_core_mult, max_core_mult, idle_timeout);
     }
 
     dynbranch(const dynbranch&) = delete;
@@ -91,6 +92,15 @@ public:
         return branch->submit_future<T>(std::forward<F>(task), std::forward<Args>(args)...);
     }
 
+#if defined(WSP_HAS_COROUTINES)
+    /**
+     * @brief resume the awaiting coroutine on a worker of this branch
+     */
+    details::schedule_awaiter<workbranch> schedule() {
+        return branch->schedule();
+    }
+#endif
+
     /**
      * @brief wait for all tasks to complete or timeout.
      *
@@ -101,6 +111,17 @@ public:
         return branch->wait_tasks(timeout);
     }
 
+    /**
+     * @brief shut the branch down (see workbranch::shutdown); the supervisor no longer adds or removes workers.
+     *
+     * @param mode what happens to the queued tasks.
+     * @param timeout how long to wait for the workers.
+     * @return false on timeout.
+     */
+    bool shutdown(shutdown_mode mode = shutdown_mode::drain, std::chrono::milliseconds timeout = default_max_time) {
+        return branch->shutdown(mode, timeout);
+    }
+
     /**
      * @brief get current number of workers.
      */
@@ -115,6 +136,28 @@ public:
         return branch->num_tasks();
     }
 
+    /**
+     * @brief handle exceptions thrown by void tasks (see workbranch::set_error_handler).
+     */
+    void set_error_handler(workbranch::error_handler handler,
+                           size_t max_per_second = exception_sink::default_rate) {
+        branch->set_error_handler(std::move(handler), max_per_second);
+    }
+
+    /**
+     * @brief take the exceptions collected from void tasks.
+     */
+    std::vector<std::exception_ptr> drain_exceptions() {
+        return branch->drain_exceptions();
+    }
+
+    /**
+     * @brief snapshot of the branch metrics.
+     */
+    branch_stats stats() {
+        return branch->stats();
+    }
+
     /**
      * @brief pause supervision and extend the wait interval.
      *
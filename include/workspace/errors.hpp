@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Where exceptions escaping fire-and-forget tasks go
+ *
+ * Exceptions are first rate limited (a lock-free per-second budget), so an error storm costs
+ * each worker one atomic increment per error once the budget is spent. Admitted exceptions are
+ * passed to the user handler, or kept in a bounded collector for the caller to drain.
+ * No iostream I/O ever happens on a worker.
+ */
+class exception_sink {
+public:
+    using handler_t = std::function<void(std::exception_ptr)>;
+    constexpr static size_t default_capacity = 128;
+    constexpr static size_t default_rate = 1000;
+
+private:
+    std::mutex lok;
+    handler_t handler;
+    std::deque<std::exception_ptr> collected;
+    size_t capacity = default_capacity;
+    std::atomic<size_t> rate{default_rate};
+
+    std::atomic<int64_t> window{0};
+    std::atomic<uint64_t> in_window{0};
+
+    alignas(64) std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> dropped{0};
+
+    bool admit() {
+        auto budget = rate.load(std::memory_order_relaxed);
+        if (budget == 0) return true;
+        auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+        auto seen = window.load(std::memory_order_relaxed);
+        if (seen != now && window.compare_exchange_strong(seen, now, std::memory_order_relaxed)) {
+            in_window.store(0, std::memory_order_relaxed);
+        }
+        return in_window.fetch_add(1, std::memory_order_relaxed) < budget;
+    }
+
+public:
+    /**
+     * @brief set the handler
+     * @param fn called with each admitted exception (calls are serialized); nullptr to collect instead
+     * @param max_per_second budget of admitted exceptions per second (0 = unlimited)
+     */
+    void set_handler(handler_t fn, size_t max_per_second) {
+        std::lock_guard<std::mutex> lock(lok);
+        handler = std::move(fn);
+        rate.store(max_per_second, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief set how many exceptions the collector keeps (oldest are dropped first)
+     */
+    void set_capacity(size_t cap) {
+        std::lock_guard<std::mutex> lock(lok);
+        capacity = cap;
+        while (collected.size() > capacity) {
+            collected.pop_front();
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // called on the worker that caught the exception
+    void report(std::exception_ptr ex) noexcept {
+        total.fetch_add(1, std::memory_order_relaxed);
+        if (!admit()) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(lok);
+        if (handler) {
+            try {
+                handler(ex);
+            } catch (...) {
+                dropped.fetch_add(1, std::memory_order_relaxed);  // the handler itself failed
+            }
+            return;
+        }
+        if (capacity == 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (collected.size() >= capacity) {
+            collected.pop_front();
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        collected.emplace_back(std::move(ex));
+    }
+
+    /**
+     * @brief take the collected exceptions
+     * @return oldest first
+     */
+    std::vector<std::exception_ptr> drain() {
+        std::lock_guard<std::mutex> lock(lok);
+        std::vector<std::exception_ptr> res(collected.begin(), collected.end());
+        collected.clear();
+        return res;
+    }
+
+    uint64_t count() const {
+        return total.load(std::memory_order_relaxed);
+    }
+    uint64_t count_suppressed() const {
+        return suppressed.load(std::memory_order_relaxed);
+    }
+    uint64_t count_dropped() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Set on the future of a queued task that shutdown(shutdown_mode::cancel) did not run
+ */
+class task_cancelled : public std::runtime_error {
+public:
+    task_cancelled()
+      : std::runtime_error("task cancelled by shutdown") {
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
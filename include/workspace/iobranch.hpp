@@ -0,0 +1,363 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <workspace/workbranch.hpp>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define WSP_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace wsp {
+
+enum class io_backend {
+    automatic,  // io_uring when the kernel allows it, threads otherwise
+    io_uring,   // io_uring only (falls back to threads if the ring cannot be created)
+    threads     // blocking pread/pwrite on dedicated I/O threads
+};
+
+namespace details {
+
+/**
+ * @brief Asynchronous file I/O next to the CPU branches
+ *
+ * Reads and writes go to an io_uring ring (one reaper thread waits for completions) or, where
+ * io_uring is unavailable (old kernel, seccomp, non-Linux), to a few dedicated I/O threads.
+ * Either way no CPU worker blocks in read(2)/write(2): results come back as a std::future, or as
+ * a callback run on the target workbranch.
+ * @note buffers must stay valid until the operation completed; the destructor waits for every
+ * pending operation
+ */
+class iobranch {
+    using callback_t = std::function<void(ssize_t)>;
+
+    struct io_op {
+        struct iovec iov;
+        callback_t done;  // receives the byte count or -errno
+    };
+
+    workbranch& target;
+    std::atomic_size_t pending{0};
+    std::mutex lok;
+    std::condition_variable idle_cv;
+
+#if defined(WSP_HAS_IO_URING)
+    struct ring_t {
+        int fd = -1;
+        unsigned entries = 0;
+        void* sq_ptr = nullptr;
+        size_t sq_size = 0;
+        void* cq_ptr = nullptr;
+        size_t cq_size = 0;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqes_size = 0;
+
+        unsigned* sq_head;
+        unsigned* sq_tail;
+        unsigned* sq_mask;
+        unsigned* sq_array;
+        unsigned* cq_head;
+        unsigned* cq_tail;
+        unsigned* cq_mask;
+        io_uring_cqe* cqes;
+    } ring;
+
+    std::mutex sq_lok;  // producers share the submission queue
+    std::condition_variable sq_cv;
+    unsigned in_ring = 0;  // operations the ring holds (guarded by sq_lok)
+    std::thread reaper;
+#endif
+
+    std::unique_ptr<workbranch> io_workers;  // thread backend
+
+public:
+    /**
+     * @brief construct an iobranch
+     * @param target workbranch running the completion callbacks
+     * @param backend io_uring, threads, or automatic choice
+     * @param depth ring entries (the thread backend runs min(depth, 4) I/O threads)
+     */
+    explicit iobranch(workbranch& target, io_backend backend = io_backend::automatic, unsigned depth = 256)
+      : target(target) {
+#if defined(WSP_HAS_IO_URING)
+        if (backend != io_backend::threads && setup_ring(depth)) {
+            reaper = std::thread(&iobranch::reap, this);
+            return;
+        }
+#endif
+        (void)backend;
+        io_workers.reset(new workbranch(static_cast<int>(std::min(depth, 4u))));
+    }
+
+    iobranch(const iobranch&) = delete;
+    iobranch(iobranch&&) = delete;
+
+    ~iobranch() {
+        wait_tasks();
+#if defined(WSP_HAS_IO_URING)
+        if (ring.fd >= 0) {
+            push_op(IORING_OP_NOP, -1, nullptr, 0);  // wake the reaper: a null op means stop
+            reaper.join();
+            munmap(ring.sqes, ring.sqes_size);
+            if (ring.cq_ptr != ring.sq_ptr) munmap(ring.cq_ptr, ring.cq_size);
+            munmap(ring.sq_ptr, ring.sq_size);
+            close(ring.fd);
+        }
+#endif
+    }
+
+public:
+    /**
+     * @brief read from a file without blocking a worker
+     * @param fd file descriptor
+     * @param buf destination, valid until the operation completes
+     * @param len bytes to read
+     * @param off file offset
+     * @return std::future<ssize_t> bytes read, or std::system_error
+     */
+    std::future<ssize_t> async_read(int fd, void* buf, size_t len, off_t off) {
+        return with_future([&](callback_t cb) { submit_io(false, fd, buf, len, off, std::move(cb)); });
+    }
+
+    /**
+     * @brief read from a file and run a callback on the target workbranch
+     * @param cb <void(ssize_t)> receives the bytes read, or -errno on failure
+     */
+    template <typename F>
+    void async_read(int fd, void* buf, size_t len, off_t off, F&& cb) {
+        submit_io(false, fd, buf, len, off, dispatch(std::forward<F>(cb)));
+    }
+
+    /**
+     * @brief write to a file without blocking a worker
+     * @param fd file descriptor
+     * @param buf source, valid until the operation completes
+     * @param len bytes to write
+     * @param off file offset
+     * @return std::future<ssize_t> bytes written, or std::system_error
+     */
+    std::future<ssize_t> async_write(int fd, const void* buf, size_t len, off_t off) {
+        return with_future(
+            [&](callback_t cb) { submit_io(true, fd, const_cast<void*>(buf), len, off, std::move(cb)); });
+    }
+
+    /**
+     * @brief write to a file and run a callback on the target workbranch
+     * @param cb <void(ssize_t)> receives the bytes written, or -errno on failure
+     */
+    template <typename F>
+    void async_write(int fd, const void* buf, size_t len, off_t off, F&& cb) {
+        submit_io(true, fd, const_cast<void*>(buf), len, off, dispatch(std::forward<F>(cb)));
+    }
+
+    /**
+     * @brief whether the operations go through io_uring
+     */
+    bool uses_io_uring() const {
+#if defined(WSP_HAS_IO_URING)
+        return ring.fd >= 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief get number of operations not completed yet
+     */
+    size_t num_pending() const {
+        return pending.load();
+    }
+
+    /**
+     * @brief wait for every pending operation (their callbacks may still be queued on the target)
+     * @param timeout maximum wait
+     * @return true if nothing is pending anymore
+     */
+    bool wait_tasks(std::chrono::milliseconds timeout = default_max_time) {
+        std::unique_lock<std::mutex> lock(lok);
+        return idle_cv.wait_for(lock, timeout, [this] { return pending.load() == 0; });
+    }
+
+private:
+    template <typename Submit>
+    static std::future<ssize_t> with_future(Submit&& submit) {
+        auto prom = std::make_shared<std::promise<ssize_t>>();
+        auto res = prom->get_future();
+        submit([prom](ssize_t n) {
+            if (n < 0) {
+                prom->set_exception(std::make_exception_ptr(
+                    std::system_error(static_cast<int>(-n), std::system_category(), "wsp::iobranch")));
+            } else {
+                prom->set_value(n);
+            }
+        });
+        return res;
+    }
+
+    template <typename F>
+    callback_t dispatch(F&& cb) {
+        return [this, cb = std::forward<F>(cb)](ssize_t n) mutable {
+            target.submit([cb = std::move(cb), n]() mutable { cb(n); });
+        };
+    }
+
+    void finish(io_op* op, ssize_t res) {
+        try {
+            op->done(res);
+        } catch (...) {
+            // a full target queue or a broken promise must not kill the completion thread
+        }
+        delete op;
+        if (pending.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(lok);
+            idle_cv.notify_all();
+        }
+    }
+
+    void submit_io(bool write, int fd, void* buf, size_t len, off_t off, callback_t cb) {
+        auto op = new io_op{{buf, len}, std::move(cb)};
+        pending.fetch_add(1);
+#if defined(WSP_HAS_IO_URING)
+        if (ring.fd >= 0) {
+            push_op(write ? IORING_OP_WRITEV : IORING_OP_READV, fd, op, off);
+            return;
+        }
+#endif
+        io_workers->submit([this, write, fd, op, off] {
+            ssize_t n = write ? pwrite(fd, op->iov.iov_base, op->iov.iov_len, off)
+                              : pread(fd, op->iov.iov_base, op->iov.iov_len, off);
+            finish(op, n < 0 ? -errno : n);
+        });
+    }
+
+#if defined(WSP_HAS_IO_URING)
+    bool setup_ring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false;
+
+        ring.fd = fd;
+        ring.entries = params.sq_entries;
+        ring.sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) ring.sq_size = ring.cq_size = std::max(ring.sq_size, ring.cq_size);
+
+        ring.sq_ptr = mmap(nullptr, ring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                           IORING_OFF_SQ_RING);
+        ring.cq_ptr = single ? ring.sq_ptr
+                             : mmap(nullptr, ring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                    IORING_OFF_CQ_RING);
+        ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        ring.sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (ring.sq_ptr == MAP_FAILED || ring.cq_ptr == MAP_FAILED || ring.sqes == MAP_FAILED) {
+            if (ring.sqes != MAP_FAILED) munmap(ring.sqes, ring.sqes_size);
+            if (!single && ring.cq_ptr != MAP_FAILED) munmap(ring.cq_ptr, ring.cq_size);
+            if (ring.sq_ptr != MAP_FAILED) munmap(ring.sq_ptr, ring.sq_size);
+            close(fd);
+            ring.fd = -1;
+            return false;
+        }
+
+        auto sq = static_cast<char*>(ring.sq_ptr);
+        auto cq = static_cast<char*>(ring.cq_ptr);
+        ring.sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        ring.sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring.sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring.sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring.cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring.cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring.cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring.cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // queue one sqe and hand it to the kernel; waits while the ring is full, fails the op on a hard error
+    void push_op(uint8_t opcode, int fd, io_op* op, off_t off) {
+        std::unique_lock<std::mutex> lock(sq_lok);
+        sq_cv.wait(lock, [this] { return in_ring < ring.entries; });
+        ++in_ring;
+
+        auto tail = *ring.sq_tail;
+        auto idx = tail & *ring.sq_mask;
+        auto& sqe = ring.sqes[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        if (op) {
+            sqe.addr = reinterpret_cast<uint64_t>(&op->iov);
+            sqe.len = 1;
+            sqe.off = static_cast<uint64_t>(off);
+        }
+        sqe.user_data = reinterpret_cast<uint64_t>(op);
+        ring.sq_array[idx] = idx;
+        __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        // EAGAIN/EBUSY: the completion queue is full, the reaper is about to drain it
+        int err = 0;
+        while (syscall(__NR_io_uring_enter, ring.fd, 1, 0, 0, nullptr, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                err = errno;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        // any other error: the kernel did not take the sqe, so take it back and fail the op
+        if (err == 0 || !op || __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) != tail) return;
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+        --in_ring;
+        sq_cv.notify_one();
+        lock.unlock();
+        finish(op, -err);
+    }
+
+    // completion thread: wait for cqes and complete their operations
+    void reap() {
+        bool stopping = false;
+        while (!stopping || pending.load() > 0) {
+            auto head = *ring.cq_head;
+            auto tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                continue;
+            }
+            unsigned done = 0;
+            for (; head != tail; ++head, ++done) {
+                auto& cqe = ring.cqes[head & *ring.cq_mask];
+                auto op = reinterpret_cast<io_op*>(cqe.user_data);
+                auto res = cqe.res;
+                __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+                if (op) {
+                    finish(op, res);
+                } else {
+                    stopping = true;
+                }
+            }
+            std::lock_guard<std::mutex> lock(sq_lok);
+            in_ring -= done;
+            sq_cv.notify_all();
+        }
+    }
+#endif
+};
+
+}  // namespace details
+}  // namespace wsp
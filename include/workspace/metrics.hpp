@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <workspace/arena.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace wsp {
+namespace details {
+
+// floor(log2(v)), v > 0
+inline int log2_floor(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return static_cast<int>(idx);
+#else
+    int n = 0;
+    while (v >>= 1) ++n;
+    return n;
+#endif
+}
+
+/**
+ * @brief Log-linear bucket layout shared by histogram and histogram_snapshot (HDR style)
+ * @note Values below 16 are exact, above that every power of two is split into 16 buckets,
+ * so the relative error is at most 6.25%. Values beyond 2^41 land in the last bucket.
+ */
+struct histogram_layout {
+    constexpr static int sub_bits = 4;
+    constexpr static uint64_t sub_count = 1 << sub_bits;
+    constexpr static int max_msb = 40;
+    constexpr static size_t buckets = (max_msb - sub_bits + 2) * sub_count;
+
+    static size_t index(uint64_t v) {
+        if (v < sub_count) return static_cast<size_t>(v);
+        auto msb = log2_floor(v);
+        if (msb > max_msb) return buckets - 1;
+        auto sub = (v >> (msb - sub_bits)) & (sub_count - 1);
+        return static_cast<size_t>((msb - sub_bits + 1) * sub_count + sub);
+    }
+
+    // highest value that falls into the bucket
+    static uint64_t upper(size_t idx) {
+        if (idx < sub_count) return idx;
+        auto msb = static_cast<int>(idx / sub_count) + sub_bits - 1;
+        auto sub = idx % sub_count;
+        auto width = uint64_t(1) << (msb - sub_bits);
+        return ((sub_count + sub) << (msb - sub_bits)) + width - 1;
+    }
+};
+
+/**
+ * @brief Plain copy of a histogram, safe to merge and query
+ */
+class histogram_snapshot {
+    std::array<uint64_t, histogram_layout::buckets> counts{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maximum = 0;
+
+    friend class histogram;
+
+public:
+    /**
+     * @brief number of recorded values
+     */
+    uint64_t count() const {
+        return total;
+    }
+
+    /**
+     * @brief largest recorded value
+     */
+    uint64_t max() const {
+        return maximum;
+    }
+
+    /**
+     * @brief arithmetic mean of the recorded values
+     */
+    double mean() const {
+        return total ? static_cast<double>(sum) / total : 0;
+    }
+
+    /**
+     * @brief value at a percentile
+     * @param p percentile in [0, 100], e.g. 99.9
+     * @return upper bound of the bucket holding the percentile (0 if empty)
+     */
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        auto rank = static_cast<uint64_t>(std::max(1.0, std::min(p, 100.0) / 100.0 * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(histogram_layout::upper(i), maximum);
+        }
+        return maximum;
+    }
+
+    /**
+     * @brief add another snapshot into this one
+     */
+    histogram_snapshot& merge(const histogram_snapshot& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        maximum = std::max(maximum, other.maximum);
+        return *this;
+    }
+
+    /**
+     * @brief record a value (not thread-safe, for single-threaded use such as benchmarks)
+     */
+    void record(uint64_t v) {
+        ++counts[histogram_layout::index(v)];
+        ++total;
+        sum += v;
+        maximum = std::max(maximum, v);
+    }
+};
+
+/**
+ * @brief Live histogram with a single writer and any number of readers
+ * @note record() is a plain load/store on relaxed atomics: only the owning thread may call it
+ */
+class histogram {
+    std::array<std::atomic<uint64_t>, histogram_layout::buckets> counts;
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static void bump(std::atomic<uint64_t>& c, uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+public:
+    histogram() {
+        for (auto& each : counts) each.store(0, std::memory_order_relaxed);
+    }
+
+    void record(uint64_t v) {
+        bump(counts[histogram_layout::index(v)], 1);
+        bump(total, 1);
+        bump(sum, v);
+        if (v > maximum.load(std::memory_order_relaxed)) maximum.store(v, std::memory_order_relaxed);
+    }
+
+    // clear all counts (only while nobody records)
+    void reset() {
+        for (auto& each : counts) each.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief add the current content into a snapshot
+     */
+    void collect(histogram_snapshot& snap) const {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            snap.counts[i] += counts[i].load(std::memory_order_relaxed);
+        }
+        snap.total += total.load(std::memory_order_relaxed);
+        snap.sum += sum.load(std::memory_order_relaxed);
+        snap.maximum = std::max(snap.maximum, maximum.load(std::memory_order_relaxed));
+    }
+};
+
+/**
+ * @brief Counters owned by one worker, padded so that workers never share a cache line
+ */
+struct alignas(64) worker_metrics {
+    histogram queue_wait;  // ns between submit and start
+    histogram execution;   // ns spent running the task
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> busy_ns{0};
+    std::chrono::steady_clock::time_point born = std::chrono::steady_clock::now();
+
+    // called by the owning worker only
+    void record(uint64_t wait_ns, uint64_t exec_ns) {
+        queue_wait.record(wait_ns);
+        execution.record(exec_ns);
+        completed.store(completed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        busy_ns.store(busy_ns.load(std::memory_order_relaxed) + exec_ns, std::memory_order_relaxed);
+    }
+
+    // start over for a new worker (only while nobody records)
+    void reset() {
+        queue_wait.reset();
+        execution.reset();
+        completed.store(0, std::memory_order_relaxed);
+        busy_ns.store(0, std::memory_order_relaxed);
+        born = std::chrono::steady_clock::now();
+    }
+};
+
+/**
+ * @brief Point-in-time view of a workbranch
+ * @note Counters are cumulative since construction; diff two snapshots for a rate
+ */
+struct branch_stats {
+    uint64_t submitted = 0;         // tasks handed to the branch
+    uint64_t completed = 0;         // tasks finished (a sequence counts once)
+    uint64_t failed = 0;            // void tasks that threw
+    uint64_t suppressed = 0;        // exceptions dropped by the error rate limit
+    size_t workers = 0;             // live workers
+    uint64_t spawned = 0;           // workers created (including the initial ones)
+    uint64_t exited = 0;            // workers deleted
+    size_t queued = 0;              // tasks waiting in the queue
+    uint64_t busy_ns = 0;           // time workers spent running tasks
+    uint64_t worker_ns = 0;         // time workers were alive
+    histogram_snapshot queue_wait;  // ns between submit and start
+    histogram_snapshot execution;   // ns spent running a task
+    arena_stats arena;              // scratch memory of this_worker::arena()
+
+    /**
+     * @brief fraction of worker time spent running tasks, in [0, 1]
+     */
+    double utilisation() const {
+        return worker_ns ? static_cast<double>(busy_ns) / worker_ns : 0;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <vector>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+namespace details {
+
+// chunks are sized to stay in a core's L2 cache; inputs below two chunks run sequentially
+constexpr size_t parallel_grain_bytes = 64 * 1024;
+
+/**
+ * @brief split n elements of a given size into cache-sized chunks, at most 4 per participant
+ * @return number of chunks, 1 when the input is too small to be worth splitting
+ */
+inline size_t plan_chunks(size_t n, size_t elem_size, size_t participants) {
+    auto grain = std::max<size_t>(1, parallel_grain_bytes / std::max<size_t>(1, elem_size));
+    if (n < 2 * grain || participants < 2) return 1;
+    return std::min((n + grain - 1) / grain, participants * 4);
+}
+
+// [begin, end) of chunk i among k chunks of n elements
+inline std::pair<size_t, size_t> chunk_range(size_t n, size_t k, size_t i) {
+    return {n * i / k, n * (i + 1) / k};
+}
+
+/**
+ * @brief run body(0..chunks-1) on the branch's workers and the calling thread
+ *
+ * Participants take chunk indices from a shared counter, so the caller works through whatever the
+ * workers have not started: called from a worker of the same branch it still completes, even if
+ * every other worker is busy.
+ * @note rethrows the first exception thrown by body, after every chunk has finished
+ */
+template <typename F>
+void run_chunks(workbranch& br, size_t chunks, F&& body) {
+    if (chunks == 0) return;
+    if (chunks == 1) {
+        body(size_t(0));
+        return;
+    }
+
+    struct shared {
+        std::atomic<size_t> next{0};
+        size_t done = 0;  // guarded by lok
+        std::exception_ptr error;
+        std::mutex lok;
+        std::condition_variable cv;
+    };
+    auto st = std::make_shared<shared>();  // helpers may start after the caller has returned
+    auto* fn = &body;
+    auto work = [st, fn, chunks] {
+        for (size_t i; (i = st->next.fetch_add(1)) < chunks;) {
+            std::exception_ptr err;
+            try {
+                (*fn)(i);
+            } catch (...) {
+                err = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(st->lok);
+            if (err && !st->error) st->error = err;
+            if (++st->done == chunks) st->cv.notify_all();
+        }
+    };
+
+    auto helpers = std::min(chunks - 1, br.num_workers());
+    for (size_t h = 0; h < helpers; ++h) br.submit(work);
+    work();
+
+    std::unique_lock<std::mutex> lock(st->lok);
+    st->cv.wait(lock, [&st, chunks] { return st->done == chunks; });
+    if (st->error) std::rethrow_exception(st->error);
+}
+
+}  // namespace details
+
+/**
+ * @brief reduce a range on a workbranch (and the calling thread)
+ * @param br workbranch lending its workers
+ * @param first random access iterator
+ * @param last random access iterator
+ * @param init initial value
+ * @param op associative operation, applied in range order (need not be commutative)
+ * @return init op *first op ... op *(last - 1)
+ */
+template <typename It, typename T, typename Op = std::plus<T>>
+T parallel_reduce(details::workbranch& br, It first, It last, T init, Op op = Op()) {
+    using value_t = typename std::iterator_traits<It>::value_type;
+    auto n = static_cast<size_t>(last - first);
+    auto k = details::plan_chunks(n, sizeof(value_t), br.num_workers() + 1);
+    if (k == 1) return std::accumulate(first, last, init, op);
+
+    std::vector<T> partial(k, init);
+    std::vector<char> used(k, 0);
+    details::run_chunks(br, k, [&](size_t i) {
+        auto r = details::chunk_range(n, k, i);
+        if (r.first == r.second) return;
+        auto it = first + r.first;
+        T acc = *it;
+        for (++it; it != first + r.second; ++it) acc = op(std::move(acc), *it);
+        partial[i] = std::move(acc);
+        used[i] = 1;
+    });
+    for (size_t i = 0; i < k; ++i) {
+        if (used[i]) init = op(std::move(init), std::move(partial[i]));
+    }
+    return init;
+}
+
+/**
+ * @brief inclusive prefix scan of a range on a workbranch (and the calling thread)
+ * @param d_first output, may be equal to first
+ * @param op associative operation
+ * @return end of the output
+ * @note two passes: chunk totals, then each chunk scanned with the total of the chunks before it
+ */
+template <typename It, typename OutIt, typename Op = std::plus<typename std::iterator_traits<It>::value_type>>
+OutIt parallel_inclusive_scan(details::workbranch& br, It first, It last, OutIt d_first, Op op = Op()) {
+    using value_t = typename std::iterator_traits<It>::value_type;
+    auto n = static_cast<size_t>(last - first);
+    if (n == 0) return d_first;
+    auto k = details::plan_chunks(n, sizeof(value_t), br.num_workers() + 1);
+
+    auto scan = [&op](It from, It to, OutIt out, const value_t* carry) {
+        value_t acc = carry ? op(*carry, *from) : *from;
+        *out = acc;
+        for (++from, ++out; from != to; ++from, ++out) {
+            acc = op(std::move(acc), *from);
+            *out = acc;
+        }
+    };
+    if (k == 1) {
+        scan(first, last, d_first, nullptr);
+        return d_first + n;
+    }
+
+    // pass 1: the first chunk is scanned right away, the others are only summed
+    std::vector<value_t> totals(k);
+    details::run_chunks(br, k, [&](size_t i) {
+        auto r = details::chunk_range(n, k, i);
+        if (i == 0) {
+            scan(first, first + r.second, d_first, nullptr);
+            totals[0] = *(d_first + (r.second - 1));
+            return;
+        }
+        auto it = first + r.first;
+        value_t acc = *it;
+        for (++it; it != first + r.second; ++it) acc = op(std::move(acc), *it);
+        totals[i] = std::move(acc);
+    });
+    for (size_t i = 1; i < k; ++i) totals[i] = op(totals[i - 1], totals[i]);
+
+    // pass 2: scan the other chunks starting from the total of the chunks before them
+    details::run_chunks(br, k - 1, [&](size_t j) {
+        auto i = j + 1;
+        auto r = details::chunk_range(n, k, i);
+        scan(first + r.first, first + r.second, d_first + r.first, &totals[i - 1]);
+    });
+    return d_first + n;
+}
+
+/**
+ * @brief sort a range on a workbranch (and the calling thread)
+ * @param comp strict weak ordering
+ * @note chunks are sorted in parallel, then merged pairwise; every merge round is itself split
+ * into independent pieces, so the last rounds keep all participants busy. Uses a buffer of
+ * (last - first) elements; not stable.
+ */
+template <typename It, typename Comp = std::less<typename std::iterator_traits<It>::value_type>>
+void parallel_sort(details::workbranch& br, It first, It last, Comp comp = Comp()) {
+    using value_t = typename std::iterator_traits<It>::value_type;
+    auto n = static_cast<size_t>(last - first);
+    auto participants = br.num_workers() + 1;
+    auto k = details::plan_chunks(n, sizeof(value_t), participants);
+    if (k == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+    k = std::min(k, participants);  // one sorted run per participant, merging does the rest
+
+    std::vector<size_t> bounds(k + 1);
+    for (size_t i = 0; i <= k; ++i) bounds[i] = n * i / k;
+    details::run_chunks(br, k, [&](size_t i) { std::sort(first + bounds[i], first + bounds[i + 1], comp); });
+
+    std::vector<value_t> buffer(n);
+    bool in_buffer = false;  // where the current runs live
+    while (bounds.size() > 2) {
+        auto runs = bounds.size() - 1;
+        auto pairs = (runs + 1) / 2;
+        auto pieces = std::max<size_t>(1, participants / pairs);
+        // piece j of pair p: slice j of the left run, and the part of the right run that sorts
+        // between the first element of that slice and the first element of the next one
+        auto merge_piece = [&](auto src, auto dst, size_t task) {
+            auto p = task / pieces, j = task % pieces;
+            auto lo = bounds[2 * p];
+            auto mid = bounds[std::min(2 * p + 1, runs)];
+            auto hi = bounds[std::min(2 * p + 2, runs)];
+            auto split = [&](size_t pos) -> size_t {
+                if (pos == lo) return mid;
+                if (pos == mid) return hi;
+                return static_cast<size_t>(std::lower_bound(src + mid, src + hi, src[pos], comp) - src);
+            };
+            auto a_lo = lo + (mid - lo) * j / pieces, a_hi = lo + (mid - lo) * (j + 1) / pieces;
+            auto b_lo = split(a_lo), b_hi = split(a_hi);
+            std::merge(std::make_move_iterator(src + a_lo), std::make_move_iterator(src + a_hi),
+                       std::make_move_iterator(src + b_lo), std::make_move_iterator(src + b_hi),
+                       dst + (a_lo + b_lo - mid), comp);
+        };
+        details::run_chunks(br, pairs * pieces, [&](size_t task) {
+            if (in_buffer) {
+                merge_piece(buffer.begin(), first, task);
+            } else {
+                merge_piece(first, buffer.begin(), task);
+            }
+        });
+        std::vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) merged.push_back(bounds[i]);
+        if (merged.back() != n) merged.push_back(n);
+        bounds.swap(merged);
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer) {
+        details::run_chunks(br, k, [&](size_t i) {
+            auto r = details::chunk_range(n, k, i);
+            std::move(buffer.begin() + r.first, buffer.begin() + r.second, first + r.first);
+        });
+    }
+}
+
+}  // namespace wsp
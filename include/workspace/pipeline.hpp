@@ -0,0 +1,264 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wsp {
+
+enum class stage_mode {
+    serial_in_order,      // one item at a time, in the order the input produced them
+    serial_out_of_order,  // one item at a time, in arrival order
+    parallel              // any number of items at once
+};
+
+namespace details {
+
+/**
+ * @brief Streaming pipeline of stages over a bounded number of in-flight items
+ *
+ * The input stage (serial) fills a T per item until it returns false; each item then visits the
+ * stages in declaration order. At most max_tokens items exist at once, so the memory held by the
+ * pipeline is fixed whatever the speed of each stage. A task carries its item through consecutive
+ * stages itself and only hands it to another task when a serial stage is busy, so parallel stages
+ * cost no extra scheduling. In-order stages reorder items with a small buffer (bounded by
+ * max_tokens).
+ * @tparam T item type (default constructible), e.g. a struct holding the data of every stage
+ */
+template <typename T>
+class pipeline {
+    struct token {
+        uint64_t seq;
+        T value;
+    };
+
+    struct stage_state {
+        stage_mode mode;
+        std::function<void(T&)> fn;
+
+        std::mutex lok;
+        bool busy = false;                // a task is running the stage
+        uint64_t next = 0;                // in order: sequence number to run next
+        std::map<uint64_t, token*> held;  // in order: reorder buffer
+        std::deque<token*> queue;         // out of order: arrival queue
+
+        void park(token* t) {
+            if (mode == stage_mode::serial_in_order) {
+                held.emplace(t->seq, t);
+            } else {
+                queue.push_back(t);
+            }
+        }
+
+        // next item allowed to run, nullptr if none
+        token* take() {
+            if (mode == stage_mode::serial_in_order) {
+                if (held.empty() || held.begin()->first != next) return nullptr;
+                auto t = held.begin()->second;
+                held.erase(held.begin());
+                ++next;
+                return t;
+            }
+            if (queue.empty()) return nullptr;
+            auto t = queue.front();
+            queue.pop_front();
+            return t;
+        }
+    };
+
+    size_t max_tokens;
+    std::function<bool(T&)> input;
+    std::vector<std::unique_ptr<stage_state>> stages;
+
+    std::mutex lok;
+    std::condition_variable done_cv;
+    size_t in_flight = 0;     // items produced and not finished
+    size_t pullers = 0;       // tasks submitted to run the input stage
+    bool input_busy = false;  // a task is running the input stage
+    bool input_done = false;
+    uint64_t next_seq = 0;
+    std::exception_ptr error;
+    std::atomic_bool failed{false};  // stages stop running once set
+
+public:
+    /**
+     * @param tokens maximum number of items in flight
+     */
+    explicit pipeline(size_t tokens)
+      : max_tokens(tokens ? tokens : 1) {
+    }
+
+    pipeline(const pipeline&) = delete;
+    pipeline& operator=(const pipeline&) = delete;
+
+    /**
+     * @brief set the input stage
+     * @param fn <bool(T&)> fills the item, returns false (leaving it unused) when the input is over
+     */
+    pipeline& source(std::function<bool(T&)> fn) {
+        input = std::move(fn);
+        return *this;
+    }
+
+    /**
+     * @brief append a stage
+     * @param mode serial_in_order, serial_out_of_order or parallel
+     * @param fn <void(T&)> processes one item
+     */
+    pipeline& stage(stage_mode mode, std::function<void(T&)> fn) {
+        stages.emplace_back(new stage_state());
+        stages.back()->mode = mode;
+        stages.back()->fn = std::move(fn);
+        return *this;
+    }
+
+    /**
+     * @brief run the pipeline until the input is over and every item went through all stages
+     * @param ex workbranch, dynbranch or workspace running the stages
+     * @note rethrows the first exception thrown by a stage, after which the input stops and the
+     * remaining items skip the stages; must not be called from a worker of ex (it blocks)
+     */
+    template <typename Executor>
+    void run(Executor& ex) {
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            in_flight = 0;
+            pullers = 1;
+            input_busy = input_done = false;
+            failed.store(false);
+            next_seq = 0;
+            error = nullptr;
+            for (auto& st : stages) st->next = 0;
+        }
+        ex.submit([this, &ex] { drive(ex, nullptr, 0); });
+
+        std::unique_lock<std::mutex> lock(lok);
+        done_cv.wait(lock, [this] { return finished(); });
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    bool finished() const {
+        return input_done && in_flight == 0 && pullers == 0 && !input_busy;
+    }
+
+    void fail(std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(lok);
+        if (!error) error = e;
+        failed.store(true);
+    }
+
+    void apply(stage_state& st, T& value) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        try {
+            st.fn(value);
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    }
+
+    // carry items through the stages; t == nullptr starts by running the input stage
+    template <typename Executor>
+    void drive(Executor& ex, token* t, size_t i) {
+        if (!t) t = next_input(ex, nullptr, true);
+        while (t) {
+            if (!pass(ex, t, i)) return;  // parked in a busy serial stage, its runner takes over
+            t = next_input(ex, t, false);
+            i = 0;
+        }
+    }
+
+    // run stages from i; false if the item was left to another task
+    template <typename Executor>
+    bool pass(Executor& ex, token*& t, size_t i) {
+        for (; i < stages.size(); ++i) {
+            auto& st = *stages[i];
+            if (st.mode == stage_mode::parallel) {
+                apply(st, t->value);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(st.lok);
+                st.park(t);
+                if (st.busy) return false;
+                t = st.take();
+                if (!t) return false;  // in order: an earlier item has not arrived yet
+                st.busy = true;
+            }
+            while (true) {
+                apply(st, t->value);
+                token* next;
+                {
+                    std::lock_guard<std::mutex> lock(st.lok);
+                    next = st.take();
+                    if (!next) st.busy = false;
+                }
+                if (!next) break;
+                // keep running the stage here, the processed item goes on in another task
+                auto done = t;
+                ex.submit([this, &ex, done, i] { drive(ex, done, i + 1); });
+                t = next;
+            }
+        }
+        return true;
+    }
+
+    // retire a finished item (if any) and produce the next one, nullptr if none may start now
+    template <typename Executor>
+    token* next_input(Executor& ex, token* finished_item, bool puller) {
+        bool retired = finished_item != nullptr;
+        delete finished_item;
+        uint64_t seq;
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            if (retired) --in_flight;
+            if (puller) --pullers;
+            if (input_busy || input_done || in_flight >= max_tokens) {
+                if (finished()) done_cv.notify_all();
+                return nullptr;
+            }
+            input_busy = true;
+            ++in_flight;
+            seq = next_seq++;
+        }
+
+        auto t = new token{seq, T()};
+        bool more = false;
+        if (!failed.load()) {
+            try {
+                more = input(t->value);
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+
+        bool spare = false;
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            input_busy = false;
+            if (!more) {
+                input_done = true;
+                --in_flight;
+                if (finished()) done_cv.notify_all();
+            } else if (in_flight < max_tokens) {
+                spare = true;
+                ++pullers;
+            }
+        }
+        if (!more) {
+            delete t;
+            return nullptr;
+        }
+        if (spare) ex.submit([this, &ex] { drive(ex, nullptr, 0); });  // fill the free tokens in parallel
+        return t;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
@@ -0,0 +1,265 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <workspace/workbranch.hpp>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief epoll event loop that turns fd readiness into tasks of a workbranch
+ *
+ * One thread waits in epoll_wait (never on a task queue). Fds are edge-triggered by default; every
+ * wakeup is dispatched as one task per target workbranch that runs the callbacks of the whole
+ * batch, so a burst of events costs a single thread hop. A callback never runs concurrently with
+ * itself: edges arriving while it runs are merged and handled by the same task afterwards.
+ * @note with edge-triggered fds the callback must read/write until EAGAIN
+ */
+class reactor {
+public:
+    using callback_t = std::function<void(uint32_t)>;
+
+private:
+    struct registration {
+        workbranch* target;
+        callback_t cb;
+        std::atomic<uint32_t> pending{0};  // events not handed to the callback yet
+        std::atomic_bool scheduled{false};  // a task will run the callback
+
+        // run the callback until no event is left (on the target workbranch)
+        // @return the first exception thrown by the callback
+        std::exception_ptr run() {
+            std::exception_ptr first;
+            while (true) {
+                auto ev = pending.exchange(0);
+                if (ev == 0) {
+                    scheduled.store(false);
+                    if (pending.load() == 0 || scheduled.exchange(true)) return first;
+                    continue;  // an edge arrived after the exchange, keep it on this task
+                }
+                try {
+                    cb(ev);
+                } catch (...) {
+                    if (!first) first = std::current_exception();
+                }
+            }
+        }
+    };
+    using reg_ptr = std::shared_ptr<registration>;
+
+    // owned by a submitted batch and its copies: if the branch drops the batch without running it
+    // (shutdown), the registrations are released so that the next edge schedules them again
+    struct batch_ticket {
+        std::vector<reg_ptr> regs;
+        bool ran = false;
+
+        explicit batch_ticket(std::vector<reg_ptr>&& batch)
+          : regs(std::move(batch)) {
+        }
+        ~batch_ticket() {
+            if (ran) return;
+            for (auto& reg : regs) reg->scheduled.store(false);
+        }
+        void run() {
+            ran = true;
+            run_batch(regs);
+        }
+    };
+
+    int epfd = -1;
+    int wakefd = -1;
+    int max_events;
+    std::atomic_bool stop{false};
+    std::atomic_int failure{0};  // errno that stopped the loop
+
+    std::mutex lok;
+    std::unordered_map<int, reg_ptr> regs;
+    std::thread loop;
+
+public:
+    /**
+     * @brief construct a reactor and start its thread
+     * @param batch maximum events handled per epoll_wait
+     * @note throws std::system_error if epoll or eventfd cannot be created
+     */
+    explicit reactor(int batch = 64)
+      : max_events(batch > 0 ? batch : 1) {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd < 0) throw std::system_error(errno, std::system_category(), "wsp::reactor: epoll_create1");
+        wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakefd < 0) {
+            auto err = errno;
+            close(epfd);
+            throw std::system_error(err, std::system_category(), "wsp::reactor: eventfd");
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wakefd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+        loop = std::thread(&reactor::mission, this);
+    }
+
+    reactor(const reactor&) = delete;
+    reactor(reactor&&) = delete;
+
+    /**
+     * @brief stop the loop and close the epoll instance
+     * @note callbacks already queued on a workbranch still run
+     */
+    ~reactor() {
+        stop.store(true);
+        wake();
+        loop.join();
+        close(wakefd);
+        close(epfd);
+    }
+
+public:
+    /**
+     * @brief watch a fd
+     * @param fd file descriptor (the caller keeps ownership)
+     * @param events epoll events, e.g. EPOLLIN | EPOLLOUT (EPOLLET is added unless level is true)
+     * @param target workbranch running the callback
+     * @param cb <void(uint32_t)> receives the ready events
+     * @param level use level-triggered mode
+     * @note throws std::system_error if epoll_ctl fails
+     */
+    void add(int fd, uint32_t events, workbranch& target, callback_t cb, bool level = false) {
+        auto reg = std::make_shared<registration>();
+        reg->target = &target;
+        reg->cb = std::move(cb);
+        std::lock_guard<std::mutex> lock(lok);
+        ctl(EPOLL_CTL_ADD, fd, level ? events : events | EPOLLET);
+        regs[fd] = std::move(reg);
+    }
+
+    /**
+     * @brief change the events of a watched fd
+     * @note throws std::system_error if epoll_ctl fails
+     */
+    void modify(int fd, uint32_t events, bool level = false) {
+        std::lock_guard<std::mutex> lock(lok);
+        ctl(EPOLL_CTL_MOD, fd, level ? events : events | EPOLLET);
+    }
+
+    /**
+     * @brief stop watching a fd
+     * @return false if the fd was not watched
+     * @note a callback already dispatched may still run once; close the fd only after remove
+     */
+    bool remove(int fd) {
+        std::lock_guard<std::mutex> lock(lok);
+        auto it = regs.find(fd);
+        if (it == regs.end()) return false;
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        regs.erase(it);
+        return true;
+    }
+
+    /**
+     * @brief error that stopped the event loop (epoll_wait failed with something else than EINTR)
+     * @return empty while the loop runs; once set, no callback is dispatched any more
+     */
+    std::error_code error() const {
+        auto err = failure.load();
+        return err ? std::error_code(err, std::system_category()) : std::error_code();
+    }
+
+    /**
+     * @brief get number of watched fds
+     */
+    size_t num_fds() {
+        std::lock_guard<std::mutex> lock(lok);
+        return regs.size();
+    }
+
+private:
+    void ctl(int op, int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epfd, op, fd, &ev) < 0) {
+            throw std::system_error(errno, std::system_category(), "wsp::reactor: epoll_ctl");
+        }
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        while (write(wakefd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+    }
+
+    // run every registration of a batch, then rethrow the first exception for the branch to report
+    static void run_batch(const std::vector<reg_ptr>& batch) {
+        std::exception_ptr first;
+        for (auto& reg : batch) {
+            auto err = reg->run();
+            if (err && !first) first = err;
+        }
+        if (first) std::rethrow_exception(first);
+    }
+
+    void mission() {
+        std::vector<epoll_event> events(max_events);
+        std::vector<std::pair<workbranch*, std::vector<reg_ptr>>> batches;
+        while (!stop.load()) {
+            int n = epoll_wait(epfd, events.data(), max_events, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                failure.store(errno);  // EBADF/EINVAL do not go away: stop instead of spinning
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(lok);
+                for (int i = 0; i < n; ++i) {
+                    int fd = events[i].data.fd;
+                    if (fd == wakefd) {
+                        uint64_t count;
+                        while (read(wakefd, &count, sizeof(count)) > 0) {
+                        }
+                        continue;
+                    }
+                    auto it = regs.find(fd);
+                    if (it == regs.end()) continue;  // removed meanwhile
+                    auto& reg = it->second;
+                    reg->pending.fetch_or(events[i].events);
+                    if (reg->scheduled.exchange(true)) continue;  // its task will pick the events up
+
+                    auto b = std::find_if(batches.begin(), batches.end(),
+                                          [&reg](const std::pair<workbranch*, std::vector<reg_ptr>>& each) {
+                                              return each.first == reg->target;
+                                          });
+                    if (b == batches.end()) {
+                        batches.emplace_back(reg->target, std::vector<reg_ptr>());
+                        b = batches.end() - 1;
+                    }
+                    b->second.push_back(reg);
+                }
+            }
+
+            for (auto& b : batches) {
+                auto ticket = std::make_shared<batch_ticket>(std::move(b.second));
+                b.first->submit([ticket] { ticket->run(); });
+            }
+            batches.clear();
+        }
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
@@ -0,0 +1,361 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <workspace/topology.hpp>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Unbounded single-producer single-consumer queue
+ *
+ * Items live in fixed segments; a drained segment is handed back to the producer, so a lane in steady
+ * state does not allocate. Push and pop touch no shared lock and no cache line written by the other side,
+ * except the two counters.
+ */
+template <typename T, size_t N = 64>
+class spsc_queue {
+    struct segment {
+        std::atomic<segment*> next{nullptr};
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[N];
+
+        T* slot(size_t pos) {
+            return reinterpret_cast<T*>(&slots[pos]);
+        }
+    };
+
+    alignas(64) std::atomic<uint64_t> pushed{0};  // written by the producer
+    segment* tail;
+    alignas(64) std::atomic<uint64_t> popped{0};  // written by the consumer
+    segment* head;
+    alignas(64) std::atomic<segment*> spare{nullptr};  // a drained segment for the producer
+
+public:
+    spsc_queue() {
+        head = tail = new segment();
+    }
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    ~spsc_queue() {
+        T item;
+        while (pop(item)) {
+        }
+        delete head;
+        delete spare.load();
+    }
+
+    // producer only
+    void push(T&& item) {
+        auto n = pushed.load(std::memory_order_relaxed);
+        auto pos = n % N;
+        if (pos == 0 && n != 0) {
+            auto seg = spare.exchange(nullptr, std::memory_order_acquire);
+            if (!seg) seg = new segment();
+            seg->next.store(nullptr, std::memory_order_relaxed);
+            tail->next.store(seg, std::memory_order_relaxed);  // published with the counter below
+            tail = seg;
+        }
+        new (tail->slot(pos)) T(std::move(item));
+        pushed.store(n + 1, std::memory_order_release);
+    }
+
+    // consumer only
+    bool pop(T& out) {
+        auto n = popped.load(std::memory_order_relaxed);
+        if (n == pushed.load(std::memory_order_acquire)) return false;
+        auto pos = n % N;
+        if (pos == 0 && n != 0) {
+            auto old = head;
+            head = head->next.load(std::memory_order_relaxed);
+            delete spare.exchange(old, std::memory_order_acq_rel);
+        }
+        auto item = head->slot(pos);
+        out = std::move(*item);
+        item->~T();
+        popped.store(n + 1, std::memory_order_release);
+        return true;
+    }
+
+    // any thread; exact only when neither side is running
+    bool empty() const {
+        return popped.load() == pushed.load();
+    }
+
+    // items pushed so far
+    uint64_t count() const {
+        return pushed.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Thread-per-core workspace: one single-worker workbranch per core, sharing nothing
+ *
+ * Each shard owns one workbranch with one worker, pinned to its own cpu. Tasks a shard sends to another
+ * go through a dedicated lane (an SPSC queue per pair of shards), so shards exchange messages without a
+ * shared lock or a contended cache line; the target shard runs them in batches. Partition the data by
+ * shard and keep each part on its shard to scale with the number of cores.
+ * @note the branches use their on_worker_start/on_worker_stop hooks, do not replace them
+ */
+class shardspace {
+    constexpr static size_t drain_batch = 256;  // messages run before the shard serves its queue again
+
+    using lane = spsc_queue<task_t>;
+
+    struct alignas(64) shard {
+        std::unique_ptr<workbranch> br;
+        std::atomic_bool armed{false};     // a drain task is queued
+        std::atomic_bool draining{false};  // a drain task is running
+        std::atomic_bool owned{false};     // a worker holds the sending side of the shard's lanes
+    };
+
+    // the shard worker running on the calling thread
+    struct shard_context {
+        shardspace* space = nullptr;
+        size_t index = 0;
+        bool owner = false;  // may push to the shard's outgoing lanes
+
+        static shard_context& local() {
+            thread_local shard_context ctx;
+            return ctx;
+        }
+    };
+
+    std::vector<std::unique_ptr<shard>> shards;
+    std::unique_ptr<std::atomic<lane*>[]> lanes;  // lanes[to * n + from], created on first use
+    std::atomic_bool stopping{false};
+
+public:
+    constexpr static size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * @param count number of shards (defaults to the effective cores)
+     * @param pin pin shard i to the i-th cpu of the affinity mask (Linux)
+     * @param strategy wait strategy of every shard's worker
+     */
+    explicit shardspace(size_t count = 0, bool pin = true, waitstrategy strategy = waitstrategy::blocking) {
+        if (count == 0) count = topology::effective_cores();
+        auto cpus = pin ? topology::affinity_cpus() : std::vector<unsigned>();
+        lanes.reset(new std::atomic<lane*>[count * count]);
+        for (size_t i = 0; i < count * count; ++i) lanes[i].store(nullptr);
+        for (size_t i = 0; i < count; ++i) {
+            shards.emplace_back(new shard());
+            shards[i]->br.reset(new workbranch(1, strategy));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            int cpu = cpus.empty() ? -1 : static_cast<int>(cpus[i % cpus.size()]);
+            shards[i]->br->on_worker_start([this, i, cpu] { enter(i, cpu); });
+            shards[i]->br->on_worker_stop([this, i] { leave(i); });
+        }
+    }
+
+    shardspace(const shardspace&) = delete;
+    shardspace(shardspace&&) = delete;
+
+    /**
+     * @note queued tasks and messages finish first; tasks without a result submitted meanwhile are dropped
+     */
+    ~shardspace() {
+        stopping.store(true);
+        wait_tasks();
+        for (auto& each : shards) each->br.reset();
+        for (size_t i = 0; i < shards.size() * shards.size(); ++i) delete lanes[i].load();
+    }
+
+    /**
+     * @brief number of shards
+     */
+    size_t size() const {
+        return shards.size();
+    }
+
+    /**
+     * @brief workbranch of a shard
+     */
+    workbranch& operator[](size_t shard) {
+        return *shards[shard]->br;
+    }
+
+    /**
+     * @brief shard running the calling task
+     * @return npos outside the shards of this space
+     */
+    size_t this_shard() const {
+        auto& ctx = shard_context::local();
+        return ctx.space == this ? ctx.index : npos;
+    }
+
+    /**
+     * @brief run a task on a shard
+     * @param shard target shard
+     * @param task runnable object
+     * @note from a shard, the task goes through the lane between the two shards: no lock, and the tasks
+     * a shard sends to another run in the order they were sent. From other threads it is submitted to
+     * the shard's workbranch.
+     */
+    template <typename T = normal, typename F, typename R = details::result_of_t<F>,
+              typename DR = typename std::enable_if<std::is_void<R>::value>::type>
+    void submit_to(size_t shard, F&& task) {
+        if (stopping.load(std::memory_order_relaxed)) return;
+        auto& ctx = shard_context::local();
+        if (std::is_same<T, normal>::value && ctx.space == this && claim(ctx)) {
+            post(ctx.index, shard, task_t(std::forward<F>(task)));
+        } else {
+            shards[shard]->br->submit<T>(std::forward<F>(task));
+        }
+    }
+
+    /**
+     * @brief run a task on a shard and get its result
+     * @return std::future<R>
+     * @note submitted to the shard's workbranch, also from another shard
+     */
+    template <typename T = normal, typename F, typename R = details::result_of_t<F>,
+              typename DR = typename std::enable_if<!std::is_void<R>::value, R>::type>
+    auto submit_to(size_t shard, F&& task) -> std::future<R> {
+        return shards[shard]->br->submit<T>(std::forward<F>(task));
+    }
+
+    /**
+     * @brief run a task on every shard
+     * @param task <void(size_t shard)>
+     */
+    template <typename F>
+    void broadcast(F task) {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            submit_to(i, [task, i]() mutable { task(i); });
+        }
+    }
+
+    /**
+     * @brief wait until every shard is idle and no message is in flight
+     * @param timeout timeout for waiting
+     * @return true if all tasks done
+     */
+    bool wait_tasks(std::chrono::milliseconds timeout = default_max_time) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            // quiet when a full pass saw every shard idle and nothing was sent in between
+            auto before = activity();
+            for (auto& each : shards) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now());
+                if (left.count() <= 0 || !each->br->wait_tasks(left)) return false;
+            }
+            if (activity() == before && lanes_empty()) return true;
+        }
+    }
+
+private:
+    // start hook: bind the worker to its shard
+    void enter(size_t i, int cpu) {
+        auto& ctx = shard_context::local();
+        ctx.space = this;
+        ctx.index = i;
+        ctx.owner = false;
+        if (cpu >= 0) topology::pin_current_thread(static_cast<unsigned>(cpu));
+    }
+
+    // stop hook: hand the sending side over to the next worker of the shard
+    void leave(size_t i) {
+        auto& ctx = shard_context::local();
+        if (ctx.space != this) return;
+        if (ctx.owner) shards[i]->owned.store(false, std::memory_order_release);
+        ctx = shard_context();
+    }
+
+    // only one thread may push to a shard's lanes; a compensating worker started by a blocking region
+    // falls back to submit while the first worker holds them
+    bool claim(shard_context& ctx) {
+        if (!ctx.owner) ctx.owner = !shards[ctx.index]->owned.exchange(true, std::memory_order_acq_rel);
+        return ctx.owner;
+    }
+
+    lane& lane_of(size_t from, size_t to) {
+        auto& slot = lanes[to * shards.size() + from];
+        auto l = slot.load(std::memory_order_acquire);
+        if (!l) {
+            l = new lane();  // only the sender creates it
+            slot.store(l, std::memory_order_release);
+        }
+        return *l;
+    }
+
+    void post(size_t from, size_t to, task_t&& task) {
+        lane_of(from, to).push(std::move(task));
+        // pairs with the fence in drain: either the drain sees the message or we see armed == false
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto& dst = *shards[to];
+        if (!dst.armed.load(std::memory_order_relaxed) && !dst.armed.exchange(true)) schedule(to);
+    }
+
+    void schedule(size_t to) {
+        shards[to]->br->submit([this, to] { drain(to); });
+    }
+
+    // run the messages of every lane into a shard; one running drain per shard consumes the lanes
+    void drain(size_t to) {
+        auto& dst = *shards[to];
+        dst.armed.store(false);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t budget = drain_batch;
+        while (!dst.draining.exchange(true, std::memory_order_acquire)) {
+            for (size_t from = 0; from < shards.size() && budget; ++from) {
+                auto l = lanes[to * shards.size() + from].load(std::memory_order_acquire);
+                task_t task;
+                while (l && budget && l->pop(task)) {
+                    --budget;
+                    try {
+                        task();
+                    } catch (...) {
+                        dst.br->errors.report(std::current_exception());
+                    }
+                }
+            }
+            dst.draining.store(false, std::memory_order_release);
+            // a message may have arrived while the drain submitted by its sender bailed out
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (inbound_empty(to)) return;
+            if (budget == 0) {
+                // let the tasks queued on the shard run before the next batch
+                dst.armed.store(true);
+                schedule(to);
+                return;
+            }
+        }
+    }
+
+    bool inbound_empty(size_t to) {
+        for (size_t from = 0; from < shards.size(); ++from) {
+            auto l = lanes[to * shards.size() + from].load(std::memory_order_acquire);
+            if (l && !l->empty()) return false;
+        }
+        return true;
+    }
+
+    bool lanes_empty() {
+        for (size_t to = 0; to < shards.size(); ++to) {
+            if (!inbound_empty(to)) return false;
+        }
+        return true;
+    }
+
+    // messages sent plus tasks submitted, on every shard
+    uint64_t activity() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < shards.size() * shards.size(); ++i) {
+            auto l = lanes[i].load(std::memory_order_acquire);
+            if (l) sum += l->count();
+        }
+        for (auto& each : shards) sum += each->br->submitted.load();
+        return sum;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
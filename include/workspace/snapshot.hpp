@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief An immutable value that many threads read and few threads replace (RCU style).
+ *
+ * Readers pin the current version with a lock-free guard; writers copy-modify-publish under a
+ * mutex and then wait for a grace period (every reader of the old version has left) before
+ * freeing it. Reader counts are striped over padded slots so producers do not share a cache line.
+ * @tparam T value type
+ */
+template <typename T>
+class snapshot {
+    constexpr static size_t stripes = 16;
+
+    struct alignas(64) slot {
+        std::atomic_size_t readers{0};
+    };
+
+    std::atomic<const T*> cur;
+    std::atomic_size_t epoch{0};
+    slot slots[2][stripes];
+    std::mutex writer;
+
+    static size_t stripe() {
+        thread_local size_t idx = std::hash<std::thread::id>()(std::this_thread::get_id()) % stripes;
+        return idx;
+    }
+
+public:
+    // pins one version of the value while alive
+    class reader {
+        friend class snapshot;
+        std::atomic_size_t* counter;
+        const T* ptr;
+
+        reader(std::atomic_size_t* c, const T* p)
+          : counter(c)
+          , ptr(p) {
+        }
+
+    public:
+        reader(const reader&) = delete;
+        reader(reader&& other) noexcept
+          : counter(other.counter)
+          , ptr(other.ptr) {
+            other.counter = nullptr;
+        }
+        ~reader() {
+            if (counter) counter->fetch_sub(1, std::memory_order_release);
+        }
+
+        const T& operator*() const {
+            return *ptr;
+        }
+        const T* operator->() const {
+            return ptr;
+        }
+    };
+
+    explicit snapshot(T init = T())
+      : cur(new T(std::move(init))) {
+    }
+
+    snapshot(const snapshot&) = delete;
+    snapshot(snapshot&&) = delete;
+
+    ~snapshot() {
+        delete cur.load();
+    }
+
+    /**
+     * @brief pin the current version
+     * @note lock-free; keep the guard short, writers wait for it
+     */
+    reader read() {
+        auto s = stripe();
+        while (true) {
+            auto e = epoch.load();
+            auto& counter = slots[e & 1][s].readers;
+            counter.fetch_add(1);
+            if (epoch.load() == e) {
+                return reader(&counter, cur.load());
+            }
+            counter.fetch_sub(1);  // a writer flipped the epoch meanwhile, retry on the new one
+        }
+    }
+
+    /**
+     * @brief replace the value
+     * @param modify <void(T&)> applied to a copy of the current value
+     * @note blocks until no reader can still see the old version
+     */
+    template <typename F>
+    void update(F&& modify) {
+        std::lock_guard<std::mutex> lock(writer);
+        auto old = cur.load();
+        auto next = new T(*old);
+        modify(*next);
+        cur.store(next);
+
+        auto e = epoch.fetch_add(1);
+        for (auto& each : slots[e & 1]) {
+            while (each.readers.load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        delete old;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
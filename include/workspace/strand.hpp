@@ -0,0 +1,215 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <workspace/invoke.hpp>
+#include <workspace/utility.hpp>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Run tasks one at a time and in submission order on a shared executor.
+ *
+ * A strand does not own a thread. Its tasks are queued locally and drained by a single
+ * task posted to the executor (workbranch, dynbranch or workspace), so at most one worker
+ * runs the strand at a time and ordering holds without any lock in user code.
+ * An exception thrown by a void task is reported by the executor that ran it. If the executor drops
+ * the drain task (shutdown, detached branch), the tasks left run once the next task is submitted.
+ * @note The executor must outlive the strand and every task still pending on it.
+ */
+class strand {
+    constexpr static int max_batch = 64;  // tasks run per drain before yielding the worker
+
+    struct state : std::enable_shared_from_this<state> {
+        std::mutex lok;
+        std::condition_variable idle_cv;
+        std::deque<task_t> q;
+        bool running = false;
+        bool closed = false;
+        int draining = 0;  // drains between their first task and their re-post (one, and the next for a moment)
+        std::function<void(const std::shared_ptr<state>&)> post;
+
+        void push(task_t&& task) {
+            {
+                std::lock_guard<std::mutex> lock(lok);
+                if (closed) return;
+                q.emplace_back(std::move(task));
+                if (running) return;
+                running = true;
+            }
+            post(shared_from_this());
+        }
+
+        void drain() {
+            struct scope {
+                state* s;
+                state* prev;
+                explicit scope(state* st)
+                  : s(st)
+                  , prev(current()) {
+                    current() = s;
+                    std::lock_guard<std::mutex> lock(s->lok);
+                    ++s->draining;
+                }
+                ~scope() {
+                    current() = prev;
+                    std::lock_guard<std::mutex> lock(s->lok);
+                    --s->draining;
+                    s->idle_cv.notify_all();
+                }
+            } guard(this);
+
+            for (int i = 0; i < max_batch; ++i) {
+                task_t task;
+                {
+                    std::lock_guard<std::mutex> lock(lok);
+                    if (q.empty() || closed) {
+                        running = false;
+                        return;
+                    }
+                    task = std::move(q.front());
+                    q.pop_front();
+                }
+                try {
+                    task();
+                } catch (...) {
+                    repost();  // keep draining, and let the executor report the exception
+                    throw;
+                }
+            }
+            repost();  // still running: give other tasks of the executor a turn
+        }
+
+        // strand drained by the calling thread
+        static state*& current() {
+            thread_local state* s = nullptr;
+            return s;
+        }
+
+        // post the next drain, unless the strand was closed meanwhile
+        void repost() {
+            {
+                std::lock_guard<std::mutex> lock(lok);
+                if (closed) {
+                    running = false;
+                    return;
+                }
+            }
+            post(shared_from_this());
+        }
+
+        // the posted drain was dropped by the executor (shutdown, detached branch) without running
+        void abandon() {
+            std::lock_guard<std::mutex> lock(lok);
+            running = false;  // the tasks left are drained once the next one is submitted
+        }
+    };
+
+    // owned by the posted drain and all its copies: releases the strand if the drain never runs
+    struct drain_ticket {
+        std::shared_ptr<state> s;
+        bool ran = false;
+
+        explicit drain_ticket(const std::shared_ptr<state>& st)
+          : s(st) {
+        }
+        ~drain_ticket() {
+            if (!ran) s->abandon();
+        }
+        void run() {
+            ran = true;
+            s->drain();
+        }
+    };
+
+    std::shared_ptr<state> st;
+
+public:
+    /**
+     * @brief construct a strand on top of an executor
+     * @param ex workbranch, dynbranch or workspace
+     */
+    template <typename Executor>
+    explicit strand(Executor& ex)
+      : st(std::make_shared<state>()) {
+        st->post = [&ex](const std::shared_ptr<state>& s) {
+            auto ticket = std::make_shared<drain_ticket>(s);
+            ex.submit([ticket] { ticket->run(); });
+        };
+    }
+
+    strand(const strand&) = delete;
+    strand(strand&&) = default;
+
+public:
+    /**
+     * @brief submit a task with arguments by binding them and forwarding to submit.
+     * @param task Callable object.
+     * @param args Arguments for the callable.
+     */
+    template <typename F, typename... Args, typename R = details::result_of_t<F, Args...>>
+    auto submit(F&& task, Args&&... args) -> auto {
+        auto args_tuple = std::make_tuple(std::forward<Args>(args)...);
+        auto task_lambda = [func = std::forward<F>(task), args_tuple = std::move(args_tuple)]() mutable -> R {
+            return invoke_hpp::apply(func, args_tuple);
+        };
+        return submit(std::move(task_lambda));
+    }
+
+    /**
+     * @brief execute the task after every task submitted before it
+     * @param task runnable object (normal)
+     * @return void
+     */
+    template <typename F, typename R = details::result_of_t<F>,
+              typename DR = typename std::enable_if<std::is_void<R>::value>::type>
+    void submit(F&& task) {
+        st->push(task_t(std::forward<F>(task)));
+    }
+
+    /**
+     * @brief execute the task after every task submitted before it
+     * @param task runnable object
+     * @return std::future<R>
+     */
+    template <typename F, typename R = details::result_of_t<F>,
+              typename DR = typename std::enable_if<!std::is_void<R>::value, R>::type>
+    auto submit(F&& task) -> std::future<R> {
+        auto task_ptr = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        auto future = task_ptr->get_future();
+        st->push([task = std::move(task_ptr)] { (*task)(); });
+        return future;
+    }
+
+    /**
+     * @brief get number of tasks waiting in the strand
+     * @return number
+     */
+    size_t num_tasks() {
+        std::lock_guard<std::mutex> lock(st->lok);
+        return st->q.size();
+    }
+
+    /**
+     * @brief stop the strand: queued tasks are discarded and new ones are ignored
+     * @note a task that is already running finishes normally, and close() waits for it (unless called
+     * from it): once close() returns, the strand never posts to its executor again
+     */
+    void close() {
+        std::deque<task_t> dropped;  // destroyed after unlocking: a destructor may submit to the strand
+        std::unique_lock<std::mutex> lock(st->lok);
+        st->closed = true;
+        dropped.swap(st->q);
+        auto s = st.get();
+        int self = state::current() == s ? 1 : 0;
+        s->idle_cv.wait(lock, [s, self] { return s->draining == self; });
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
@@ -8,6 +8,7 @@
 #include <mutex>
 #include <thread>
 #include <vector>
+#include <workspace/topology.hpp>
 #include <workspace/utility.hpp>
 #include <workspace/workbranch.hpp>
 
@@ -24,12 +25,17 @@ class supervisor {
         size_t min;
         size_t max;
         std::chrono::milliseconds idle_timeout;
+        double min_mult;  // > 0 if the limits follow the effective cores
+        double max_mult;
     };
 
     std::atomic_bool stop = false;
 
     size_t wmin = 0;
     size_t wmax = 0;
+    double wmin_mult = 0;
+    double wmax_mult = 0;
+    unsigned cores = 0;
     std::chrono::milliseconds tout;
     std::chrono::milliseconds tval;
 
@@ -67,11 +73,11 @@ public:
      * @brief construct a supervisor with default worker limits
      * @param idle_timeout timeout (ms) for idle worker detection
      * @param time_interval interval (ms) between supervision checks
-     * @note uses 1 as min workers and max(2, hardware_concurrency) as max workers
+     * @note uses 1 as min workers and max(2, effective cores) as max workers
      */
     explicit supervisor(std::chrono::milliseconds idle_timeout = default_time_idle,
                         std::chrono::milliseconds time_interval = default_time_interval)
-      : supervisor(1, std::max(2u, std::thread::hardware_concurrency()), idle_timeout, time_interval) {
+      : supervisor(1, std::max(2u, topology::effective_cores()), idle_timeout, time_interval) {
     }
 
     /**
@@ -81,13 +87,16 @@ public:
      * @param max_core_mult multiple for maximum workers
      * @param idle_timeout timeout (ms) for idle worker detection
      * @param time_interval interval (ms) between supervision checks
+     * @note core count comes from topology::effective_cores() and is refreshed every time_interval
      */
     explicit supervisor(cpu_multiple_tag_t, double min_core_mult, double max_core_mult,
                         std::chrono::milliseconds idle_timeout = default_time_idle,
                         std::chrono::milliseconds time_interval = default_time_interval)
-      : supervisor(static_cast<int>(std::ceil(std::max(1u, std::thread::hardware_concurrency()) * min_core_mult)),
-                   static_cast<int>(std::ceil(std::max(1u, std::thread::hardware_concurrency()) * max_core_mult)),
-                   idle_timeout, time_interval) {
+      : supervisor(static_cast<int>(topology::multiple(min_core_mult)),
+                   static_cast<int>(topology::multiple(max_core_mult)), idle_timeout, time_interval) {
+        std::lock_guard<std::mutex> lock(spv_lok);
+        wmin_mult = min_core_mult;
+        wmax_mult = max_core_mult;
     }
 
     supervisor(const supervisor&) = delete;
@@ -118,16 +127,7 @@ public:
     void supervise(std::shared_ptr<workbranch> wbr, size_t min_workers, size_t max_workers,
                    std::chrono::milliseconds idle_timeout = default_time_idle) {
         std::lock_guard<std::mutex> lock(spv_lok);
-        auto it = std::find_if(branch_limits.begin(), branch_limits.end(),
-                               [&wbr](const BranchLimits& bl) { return bl.branch == wbr; });
-        if (it == branch_limits.end()) {
-            BranchLimits bl{wbr, min_workers, max_workers, idle_timeout};
-            branch_limits.emplace_back(std::move(bl));
-        } else {
-            it->min = min_workers;
-            it->max = max_workers;
-            it->idle_timeout = idle_timeout;
-        }
+        set_limits(std::move(wbr), min_workers, max_workers, idle_timeout, 0, 0);
     }
 
     /**
@@ -136,7 +136,8 @@ public:
      * @note uses supervisor's default min, max, and idle_timeout
      */
     void supervise(std::shared_ptr<workbranch> wbr) {
-        supervise(std::move(wbr), wmin, wmax, default_idle_timeout);
+        std::lock_guard<std::mutex> lock(spv_lok);
+        set_limits(std::move(wbr), wmin, wmax, default_idle_timeout, wmin_mult, wmax_mult);
     }
 
     /**
@@ -146,13 +147,13 @@ public:
      * @param min_core_mult multiple for minimum workers
      * @param max_core_mult multiple for maximum workers
      * @param idle_timeout timeout (ms) for idle worker detection
+     * @note limits are recomputed whenever the effective core count changes
      */
     void supervise(std::shared_ptr<workbranch> wbr, cpu_multiple_tag_t, double min_core_mult, double max_core_mult,
                    std::chrono::milliseconds idle_timeout = default_time_idle) {
-        auto cores = (std::max)(1u, std::thread::hardware_concurrency());
-        auto min = static_cast<size_t>(std::ceil(cores * min_core_mult));
-        auto max = static_cast<size_t>(std::ceil(cores * max_core_mult));
-        supervise(std::move(wbr), min, max, idle_timeout);
+        std::lock_guard<std::mutex> lock(spv_lok);
+        set_limits(std::move(wbr), topology::multiple(min_core_mult), topology::multiple(max_core_mult),
+                   idle_timeout, min_core_mult, max_core_mult);
     }
 
     /**
@@ -181,18 +182,59 @@ public:
     }
 
 private:
+    void set_limits(std::shared_ptr<workbranch> wbr, size_t min_workers, size_t max_workers,
+                    std::chrono::milliseconds idle_timeout, double min_mult, double max_mult) {
+        auto it = std::find_if(branch_limits.begin(), branch_limits.end(),
+                               [&wbr](const BranchLimits& bl) { return bl.branch == wbr; });
+        if (it == branch_limits.end()) {
+            BranchLimits bl{wbr, min_workers, max_workers, idle_timeout, min_mult, max_mult};
+            branch_limits.emplace_back(std::move(bl));
+        } else {
+            it->min = min_workers;
+            it->max = max_workers;
+            it->idle_timeout = idle_timeout;
+            it->min_mult = min_mult;
+            it->max_mult = max_mult;
+        }
+    }
+
+    // re-probe the effective cores and rescale the core-multiple limits if they changed
+    void refresh_cores() {
+        auto now_cores = topology::refresh();
+        if (now_cores == cores) return;
+        cores = now_cores;
+        if (wmax_mult > 0) {
+            wmin = topology::multiple(wmin_mult);
+            wmax = topology::multiple(wmax_mult);
+        }
+        for (auto& limit : branch_limits) {
+            if (limit.max_mult > 0) {
+                limit.min = topology::multiple(limit.min_mult);
+                limit.max = topology::multiple(limit.max_mult);
+            }
+        }
+    }
+
     // loop func
     void mission() {
         std::chrono::steady_clock::time_point last_tick = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point last_probe = last_tick;
         while (!stop) {
             try {
                 {
                     std::lock_guard<std::mutex> lock(spv_lok);
+                    auto probe_time = std::chrono::steady_clock::now();
+                    if (probe_time - last_probe >= tval) {
+                        last_probe = probe_time;
+                        refresh_cores();
+                    }
                     for (auto& limit : branch_limits) {
                         auto& branch = limit.branch;
                         // get info
                         auto tknums = branch->num_tasks();
+                        // compensating workers of blocking regions come and go on their own
                         auto wknums = branch->num_workers();
+                        wknums -= std::min(wknums, branch->num_compensating());
                         // adjust
 
                         if (wknums > limit.max) {
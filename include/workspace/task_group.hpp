@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Every exception thrown by the tasks of a task_group, in the order they were caught
+ */
+class task_group_error : public std::runtime_error {
+    std::vector<std::exception_ptr> errs;
+
+    static std::string describe(const std::vector<std::exception_ptr>& errs) {
+        auto msg = std::to_string(errs.size()) + " task(s) failed";
+        try {
+            std::rethrow_exception(errs.front());
+        } catch (const std::exception& e) {
+            msg += ", first: ";
+            msg += e.what();
+        } catch (...) {
+        }
+        return msg;
+    }
+
+public:
+    explicit task_group_error(std::vector<std::exception_ptr> errors)
+      : std::runtime_error(describe(errors))
+      , errs(std::move(errors)) {
+    }
+
+    const std::vector<std::exception_ptr>& errors() const {
+        return errs;
+    }
+};
+
+/**
+ * @brief Related tasks on a workbranch that are waited for, and fail, together
+ *
+ * The first task that throws cancels the group: tasks that have not started yet are skipped and run()
+ * no longer submits, while running tasks may poll is_cancelled() to stop early. wait() helps the branch
+ * while it waits (see help_until), then throws task_group_error with every exception caught.
+ */
+class task_group {
+    struct state {
+        std::mutex lok;
+        std::condition_variable done_cv;
+        std::atomic_size_t pending{0};
+        std::atomic_bool cancelled{false};
+        std::vector<std::exception_ptr> errors;  // guarded by lok
+    };
+
+    // owned by a submitted task and its copies: counts the task done once, also if the branch drops it
+    class ticket {
+        std::shared_ptr<state> st;
+        bool done = false;
+
+    public:
+        explicit ticket(std::shared_ptr<state> s)
+          : st(std::move(s)) {
+        }
+        ticket(const ticket&) = delete;
+        ticket& operator=(const ticket&) = delete;
+
+        ~ticket() {
+            finish();
+        }
+
+        void finish() {
+            if (done) return;
+            done = true;
+            if (st->pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(st->lok);
+                st->done_cv.notify_all();
+            }
+        }
+    };
+
+    workbranch& br;
+    std::shared_ptr<state> st = std::make_shared<state>();  // tasks may outlive a group destroyed early
+
+public:
+    /**
+     * @param branch workbranch running the tasks
+     */
+    explicit task_group(workbranch& branch)
+      : br(branch) {
+    }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    /**
+     * @note waits for the tasks, dropping their exceptions
+     */
+    ~task_group() {
+        wait_quietly();
+    }
+
+    /**
+     * @brief run a task in the group
+     * @param task <void()>
+     * @return false if the group is cancelled or the branch is shut down (the task is dropped)
+     * @note a task the branch drops without running (see workbranch::shutdown) counts as done
+     */
+    template <typename F>
+    bool run(F&& task) {
+        if (st->cancelled.load(std::memory_order_relaxed) || br.is_shutdown()) return false;
+        st->pending.fetch_add(1);
+        auto done = std::make_shared<ticket>(st);
+        br.submit([st = st, done, task = std::forward<F>(task)]() mutable {
+            if (!st->cancelled.load(std::memory_order_relaxed)) {
+                try {
+                    task();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(st->lok);
+                    st->errors.push_back(std::current_exception());
+                    st->cancelled.store(true);
+                }
+            }
+            done->finish();
+        });
+        return true;
+    }
+
+    /**
+     * @brief skip the tasks that have not started yet
+     */
+    void cancel() {
+        st->cancelled.store(true);
+    }
+
+    /**
+     * @brief true once a task failed or cancel() was called, until wait() returns
+     */
+    bool is_cancelled() const {
+        return st->cancelled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief wait for every task, running queued tasks meanwhile when called on a worker
+     * @note throws task_group_error if any task threw; the group can be used again afterwards
+     */
+    void wait() {
+        auto errors = wait_quietly();
+        if (!errors.empty()) throw task_group_error(std::move(errors));
+    }
+
+private:
+    // wait, reset the group and return the exceptions caught
+    std::vector<std::exception_ptr> wait_quietly() {
+        auto s = st.get();
+        help_until([s] { return s->pending.load() == 0; },
+                   [s] {
+                       std::unique_lock<std::mutex> lock(s->lok);
+                       s->done_cv.wait(lock, [s] { return s->pending.load() == 0; });
+                   });
+        std::lock_guard<std::mutex> lock(s->lok);
+        s->cancelled.store(false);
+        auto errors = std::move(s->errors);
+        s->errors.clear();
+        return errors;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
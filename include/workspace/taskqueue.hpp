@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <deque>
 #include <mutex>
 
@@ -9,15 +10,20 @@ namespace details {
 /**
  * @brief A thread-safe task queue
  * @tparam T runnable object
- * @note The performance of pushing back is better
+ * @note The performance of pushing back is better. No task is destroyed while the lock is held: its
+ * destructor may run user code that pushes to this queue again.
  */
 template <typename T>
 class taskqueue {
+public:
+    using size_type = typename std::deque<T>::size_type;
+
+private:
     mutable std::mutex tq_lok;
     std::deque<T> q;
+    std::atomic<size_type> len{0};  // mirrors q.size() so that length() needs no lock
 
 public:
-    using size_type = typename std::deque<T>::size_type;
     taskqueue() = default;
     taskqueue(const taskqueue&) = delete;
     taskqueue(taskqueue&&) = default;
@@ -26,36 +32,70 @@ public:
     void push_back(T& v) {
         std::lock_guard<std::mutex> lock(tq_lok);
         q.emplace_back(v);
+        len.store(q.size(), std::memory_order_relaxed);
     }
 
     void push_back(T&& v) {
         std::lock_guard<std::mutex> lock(tq_lok);
         q.emplace_back(std::move(v));
+        len.store(q.size(), std::memory_order_relaxed);
     }
 
     void push_front(T& v) {
         std::lock_guard<std::mutex> lock(tq_lok);
         q.emplace_front(v);
+        len.store(q.size(), std::memory_order_relaxed);
     }
 
     void push_front(T&& v) {
         std::lock_guard<std::mutex> lock(tq_lok);
         q.emplace_front(std::move(v));
+        len.store(q.size(), std::memory_order_relaxed);
     }
 
     bool try_pop(T& tmp) {
+        T old(std::move(tmp));  // the previous task, destroyed after unlocking
         std::lock_guard<std::mutex> lock(tq_lok);
         if (!q.empty()) {
             tmp = std::move(q.front());
             q.pop_front();
+            len.store(q.size(), std::memory_order_relaxed);
             return true;
         }
         return false;
     }
 
-    size_type length() const {
+    // newest task first, for a worker helping while it waits on the tasks it just pushed
+    bool try_pop_back(T& tmp) {
+        T old(std::move(tmp));
         std::lock_guard<std::mutex> lock(tq_lok);
-        return q.size();
+        if (!q.empty()) {
+            tmp = std::move(q.back());
+            q.pop_back();
+            len.store(q.size(), std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief take every queued task
+     * @return the tasks, to be run or destroyed by the caller outside the lock
+     */
+    std::deque<T> take_all() {
+        std::deque<T> all;
+        std::lock_guard<std::mutex> lock(tq_lok);
+        all.swap(q);
+        len.store(0, std::memory_order_relaxed);
+        return all;
+    }
+
+    /**
+     * @brief number of queued tasks
+     * @note lock-free, the value may be stale by the time it is used
+     */
+    size_type length() const {
+        return len.load(std::memory_order_relaxed);
     }
 };
 
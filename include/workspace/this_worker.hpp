@@ -0,0 +1,40 @@
+#pragma once
+#include <workspace/arena.hpp>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+
+// context of the worker running the calling task
+namespace this_worker {
+
+/**
+ * @brief index of the calling worker in its workbranch
+ * @return dense index, below the largest number of workers the branch ever had; a retired worker's index
+ * is reused by the next one. size_t(-1) outside a workbranch worker.
+ */
+inline size_t index() {
+    return details::worker_context::local().index;
+}
+
+/**
+ * @brief workbranch of the calling worker
+ * @return nullptr outside a workbranch worker
+ */
+inline details::workbranch* branch() {
+    return details::worker_context::local().branch;
+}
+
+/**
+ * @brief scratch memory of the calling worker
+ * @return the worker's arena, rewound after the current task returns; outside a workbranch worker,
+ * an arena of the calling thread that is only rewound by calling reset()
+ * @note with C++17 it is a std::pmr::memory_resource, e.g. `std::pmr::vector<int> v(&wsp::this_worker::arena());`
+ */
+inline details::worker_arena& arena() {
+    if (auto arena = details::worker_arena::current()) return *arena;
+    thread_local details::worker_arena own;
+    return own;
+}
+
+}  // namespace this_worker
+}  // namespace wsp
@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief Probe how many cores this process is really allowed to use.
+ *
+ * `std::thread::hardware_concurrency()` reports the cores of the host, which is wrong inside
+ * containers and under taskset. The effective core count is the smallest of:
+ *   1. hardware_concurrency
+ *   2. the number of cpus in the sched affinity mask of the process
+ *   3. the cgroup cpu quota (v2 `cpu.max`, v1 `cpu.cfs_quota_us / cpu.cfs_period_us`), rounded up
+ *
+ * The result is cached; call refresh() to probe again (the supervisor does this periodically).
+ */
+class topology {
+public:
+    /**
+     * @brief number of cores reported by the standard library
+     * @return at least 1
+     */
+    static unsigned hardware_cores() {
+        return (std::max)(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief number of cpus in the affinity mask of the process
+     * @return 0 if unknown
+     * @note the mask of the main thread: a worker pinned to one cpu does not shrink it
+     */
+    static unsigned affinity_cores() {
+        return static_cast<unsigned>(affinity_cpus().size());
+    }
+
+    /**
+     * @brief ids of the cpus in the affinity mask of the process
+     * @return empty if unknown
+     * @note the mask of the main thread, or of the calling thread if the main thread is gone
+     */
+    static std::vector<unsigned> affinity_cpus() {
+#if defined(__linux__)
+        auto cpus = mask_of(getpid());
+        return cpus.empty() ? mask_of(0) : cpus;
+#else
+        return {};
+#endif
+    }
+
+    /**
+     * @brief ids of the cpus in the affinity mask of the calling thread
+     * @return empty if unknown
+     */
+    static std::vector<unsigned> thread_cpus() {
+#if defined(__linux__)
+        return mask_of(0);
+#else
+        return {};
+#endif
+    }
+
+    /**
+     * @brief restrict the calling thread to one cpu
+     * @return false if not supported or refused
+     */
+    static bool pin_current_thread(unsigned cpu) {
+#if defined(__linux__)
+        if (cpu >= CPU_SETSIZE) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    /**
+     * @brief cpu quota of the cgroup this process belongs to, in cores
+     * @return 0 if unlimited or unknown
+     */
+    static double quota_cores() {
+#if defined(__linux__)
+        std::ifstream cgroups("/proc/self/cgroup");
+        std::string line;
+        double quota = 0;
+        while (std::getline(cgroups, line)) {
+            // format: hierarchy-id:controller-list:path
+            auto first = line.find(':');
+            auto second = line.find(':', first + 1);
+            if (first == std::string::npos || second == std::string::npos) continue;
+            auto controllers = line.substr(first + 1, second - first - 1);
+            auto path = line.substr(second + 1);
+
+            double found = 0;
+            if (controllers.empty()) {
+                found = scan_hierarchy("/sys/fs/cgroup", path, &topology::read_cpu_max);
+            } else if (has_controller(controllers, "cpu")) {
+                found = scan_hierarchy("/sys/fs/cgroup/cpu,cpuacct", path, &topology::read_cfs_quota);
+                if (found == 0) found = scan_hierarchy("/sys/fs/cgroup/cpu", path, &topology::read_cfs_quota);
+            }
+            if (found > 0 && (quota == 0 || found < quota)) quota = found;
+        }
+        return quota;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief cached number of cores this process may use
+     * @return at least 1
+     */
+    static unsigned effective_cores() {
+        auto cores = cache().load(std::memory_order_relaxed);
+        return cores ? cores : refresh();
+    }
+
+    /**
+     * @brief probe again and update the cache
+     * @return at least 1
+     */
+    static unsigned refresh() {
+        unsigned cores = hardware_cores();
+        auto affinity = affinity_cores();
+        if (affinity > 0) cores = (std::min)(cores, affinity);
+        auto quota = quota_cores();
+        if (quota > 0) cores = (std::min)(cores, static_cast<unsigned>(std::ceil(quota)));
+        cores = (std::max)(1u, cores);
+        cache().store(cores, std::memory_order_relaxed);
+        return cores;
+    }
+
+    /**
+     * @brief scale the effective cores by a multiple
+     * @param mult multiple of cores
+     * @return ceil(cores * mult)
+     */
+    static size_t multiple(double mult) {
+        return static_cast<size_t>(std::ceil(effective_cores() * mult));
+    }
+
+private:
+#if defined(__linux__)
+    // cpus allowed to a thread (0: the calling one, the pid: the main thread)
+    static std::vector<unsigned> mask_of(pid_t tid) {
+        std::vector<unsigned> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(tid, sizeof(set), &set) == 0) {
+            for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+#endif
+
+    static std::atomic<unsigned>& cache() {
+        static std::atomic<unsigned> cores{0};
+        return cores;
+    }
+
+    static bool has_controller(const std::string& list, const std::string& name) {
+        std::stringstream ss(list);
+        std::string each;
+        while (std::getline(ss, each, ',')) {
+            if (each == name) return true;
+        }
+        return false;
+    }
+
+    // walk from the cgroup of this process up to the root and keep the tightest limit
+    static double scan_hierarchy(const std::string& mount, std::string path, double (*read)(const std::string&)) {
+        double quota = 0;
+        while (true) {
+            auto found = read(mount + (path == "/" ? "" : path));
+            if (found > 0 && (quota == 0 || found < quota)) quota = found;
+            if (path.empty() || path == "/") break;
+            auto pos = path.find_last_of('/');
+            path = pos == 0 || pos == std::string::npos ? "/" : path.substr(0, pos);
+        }
+        return quota;
+    }
+
+    // cgroup v2: "<quota|max> <period>"
+    static double read_cpu_max(const std::string& dir) {
+        std::ifstream file(dir + "/cpu.max");
+        std::string quota;
+        double period = 0;
+        if (!(file >> quota >> period) || quota == "max" || period <= 0) return 0;
+        return std::strtod(quota.c_str(), nullptr) / period;
+    }
+
+    // cgroup v1: quota is -1 when unlimited
+    static double read_cfs_quota(const std::string& dir) {
+        std::ifstream quota_file(dir + "/cpu.cfs_quota_us");
+        std::ifstream period_file(dir + "/cpu.cfs_period_us");
+        double quota = 0, period = 0;
+        if (!(quota_file >> quota) || !(period_file >> period) || quota <= 0 || period <= 0) return 0;
+        return quota / period;
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
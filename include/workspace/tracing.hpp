@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief One traced task
+ * @note timestamps are steady_clock nanoseconds
+ */
+struct trace_event {
+    const char* label;  // label given at submit (nullptr if none)
+    uint64_t branch;    // id of the workbranch
+    uint64_t worker;    // id of the worker inside the branch
+    int64_t submit;     // task queued
+    int64_t dequeue;    // task taken by the worker
+    int64_t start;      // task started
+    int64_t end;        // task finished
+};
+
+/**
+ * @brief Label the tasks submitted by this thread while alive (RAII, nestable)
+ * @note the string must outlive the trace (string literals are fine)
+ */
+class trace_label {
+    const char* prev;
+
+    static const char*& slot() {
+        thread_local const char* label = nullptr;
+        return label;
+    }
+
+public:
+    explicit trace_label(const char* name)
+      : prev(slot()) {
+        slot() = name;
+    }
+    ~trace_label() {
+        slot() = prev;
+    }
+    trace_label(const trace_label&) = delete;
+    trace_label& operator=(const trace_label&) = delete;
+
+    // label of the calling thread (nullptr if none)
+    static const char* current() {
+        return slot();
+    }
+};
+
+/**
+ * @brief Fixed-size ring of trace events: one writer (the worker), lock-free readers
+ * @note old events are overwritten; each slot is guarded by a sequence number (seqlock)
+ */
+class trace_ring {
+    // fields are relaxed atomics: a reader may overlap the writer, the sequence number tells it to retry
+    struct slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> label{nullptr};
+        std::atomic<uint64_t> branch{0}, worker{0};
+        std::atomic<int64_t> submit{0}, dequeue{0}, start{0}, end{0};
+
+        void store(const trace_event& ev) {
+            label.store(ev.label, std::memory_order_relaxed);
+            branch.store(ev.branch, std::memory_order_relaxed);
+            worker.store(ev.worker, std::memory_order_relaxed);
+            submit.store(ev.submit, std::memory_order_relaxed);
+            dequeue.store(ev.dequeue, std::memory_order_relaxed);
+            start.store(ev.start, std::memory_order_relaxed);
+            end.store(ev.end, std::memory_order_relaxed);
+        }
+
+        trace_event load() const {
+            auto m = std::memory_order_relaxed;
+            return trace_event{label.load(m), branch.load(m), worker.load(m), submit.load(m),
+                               dequeue.load(m), start.load(m), end.load(m)};
+        }
+    };
+
+    std::unique_ptr<slot[]> slots;
+    size_t cap;
+    std::atomic<uint64_t> head{0};
+
+public:
+    explicit trace_ring(size_t capacity)
+      : slots(new slot[capacity ? capacity : 1])
+      , cap(capacity ? capacity : 1) {
+    }
+
+    size_t capacity() const {
+        return cap;
+    }
+
+    // called by the owning worker only
+    void push(const trace_event& ev) {
+        auto h = head.load(std::memory_order_relaxed);
+        auto& s = slots[h % cap];
+        s.seq.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.store(ev);
+        s.seq.store(2 * h + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // append the events still in the ring (skips slots being overwritten)
+    void collect(std::vector<trace_event>& out) const {
+        auto h = head.load(std::memory_order_acquire);
+        for (auto i = h > cap ? h - cap : 0; i < h; ++i) {
+            auto& s = slots[i % cap];
+            auto seq = s.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2) continue;
+            auto ev = s.load();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != seq) continue;
+            out.push_back(ev);
+        }
+    }
+};
+
+inline void write_json_string(std::ostream& os, const char* str) {
+    os << '"';
+    for (; *str; ++str) {
+        auto c = *str;
+        switch (c) {
+            case '"': os << "\\\""; break;
+            case '\\': os << "\\\\"; break;
+            case '\n': os << "\\n"; break;
+            case '\t': os << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    static const char* hex = "0123456789abcdef";
+                    os << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                } else {
+                    os << c;
+                }
+        }
+    }
+    os << '"';
+}
+
+/**
+ * @brief Write events in Chrome Trace / Perfetto JSON format
+ * @param os output stream
+ * @param events traced tasks
+ * @note every branch becomes a process and every worker a thread; execution is a complete event
+ * on the worker's track and queue wait an async span on the branch, so stalls show up side by side
+ */
+inline void write_chrome_trace(std::ostream& os, const std::vector<trace_event>& events) {
+    int64_t base = 0;
+    for (auto& ev : events) {
+        if (base == 0 || ev.submit < base) base = ev.submit;
+    }
+    auto us = [base](int64_t ns) { return static_cast<double>(ns - base) / 1000.0; };
+
+    auto flags = os.flags();
+    auto precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    std::vector<uint64_t> named;
+    bool first = true;
+    auto sep = [&os, &first] {
+        if (!first) os << ",\n";
+        first = false;
+    };
+    uint64_t id = 0;
+    for (auto& ev : events) {
+        if (std::find(named.begin(), named.end(), ev.branch) == named.end()) {
+            named.push_back(ev.branch);
+            sep();
+            os << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << ev.branch
+               << ",\"args\":{\"name\":\"workbranch " << ev.branch << "\"}}";
+        }
+        const char* name = ev.label ? ev.label : "task";
+        ++id;
+        sep();
+        os << "{\"ph\":\"X\",\"cat\":\"task\",\"name\":";
+        write_json_string(os, name);
+        os << ",\"pid\":" << ev.branch << ",\"tid\":" << ev.worker << ",\"ts\":" << us(ev.start)
+           << ",\"dur\":" << us(ev.end) - us(ev.start)
+           << ",\"args\":{\"queue_wait_us\":" << us(ev.dequeue) - us(ev.submit)
+           << ",\"dequeue_to_start_us\":" << us(ev.start) - us(ev.dequeue) << "}}";
+        sep();
+        os << "{\"ph\":\"b\",\"cat\":\"queue\",\"name\":";
+        write_json_string(os, name);
+        os << ",\"id\":" << id << ",\"pid\":" << ev.branch << ",\"ts\":" << us(ev.submit) << "}";
+        sep();
+        os << "{\"ph\":\"e\",\"cat\":\"queue\",\"name\":";
+        write_json_string(os, name);
+        os << ",\"id\":" << id << ",\"pid\":" << ev.branch << ",\"ts\":" << us(ev.dequeue) << "}";
+    }
+    os << "]}\n";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+/**
+ * @brief Write events to a Chrome Trace JSON file
+ * @return false if the file cannot be written
+ */
+inline bool write_chrome_trace(const std::string& path, const std::vector<trace_event>& events) {
+    std::ofstream file(path);
+    if (!file) return false;
+    write_chrome_trace(file, events);
+    return static_cast<bool>(file);
+}
+
+}  // namespace details
+}  // namespace wsp
@@ -37,6 +37,7 @@ constexpr auto default_max_time =
 struct normal {};    // normal task (for type inference)
 struct urgent {};    // urgent task (for type inference)
 struct sequence {};  // sequence tasks (for type inference)
+struct blocking {};  // task that may block (for type inference)
 
 // function_: try to avoid heap allocation
 
@@ -142,7 +143,7 @@ public:
         if (other.callable) {
             other.callable->move_into(buffer);
             callable = reinterpret_cast<callable_base*>(&buffer);
-            other.callable = nullptr;
+            other.reset();
         }
     }
 
@@ -179,7 +180,7 @@ public:
             if (other.callable) {
                 other.callable->move_into(buffer);
                 callable = reinterpret_cast<callable_base*>(&buffer);
-                other.callable = nullptr;
+                other.reset();
             }
         }
         return *this;
@@ -214,6 +215,10 @@ private:
 // using task_t = std::function<void()>;
 using task_t = function_<void()>;
 
+// wait for a future, running queued tasks when called on a worker (defined in workbranch.hpp)
+template <typename Future>
+void help_wait(const Future& fut);
+
 /**
  * @brief std::future collector
  * @tparam T return type
@@ -225,10 +230,10 @@ class futures {
 public:
     using iterator = typename std::deque<std::future<T>>::iterator;
 
-    // wait for all futures
+    // wait for all futures; on a workbranch worker, run queued tasks of its branch meanwhile
     void wait() const {
         for (auto& each : futs) {
-            each.wait();
+            help_wait(each);
         }
     }
 
@@ -242,6 +247,7 @@ public:
     std::vector<T> get() {
         std::vector<T> res;
         for (auto& each : futs) {
+            help_wait(each);
             res.emplace_back(each.get());
         }
         return res;
@@ -0,0 +1,40 @@
+#pragma once
+#include <future>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+
+/**
+ * @brief wait for a future without idling the worker
+ * @param fut std::future or std::shared_future
+ * @note on a workbranch worker, runs the queued tasks of its branch until the result is ready, so a
+ * task may wait for tasks it submitted to its own branch; elsewhere it is fut.wait()
+ */
+template <typename T>
+void wait(const std::future<T>& fut) {
+    details::help_wait(fut);
+}
+
+template <typename T>
+void wait(const std::shared_future<T>& fut) {
+    details::help_wait(fut);
+}
+
+/**
+ * @brief wait for every future of a collector, helping like wait(future)
+ */
+template <typename T>
+void wait(const details::futures<T>& futs) {
+    futs.wait();
+}
+
+/**
+ * @brief wait(fut), then fut.get()
+ */
+template <typename T>
+T get(std::future<T>& fut) {
+    details::help_wait(fut);
+    return fut.get();
+}
+
+}  // namespace wsp
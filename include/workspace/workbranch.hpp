@@ -2,14 +2,20 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdlib>
+#include <deque>
+#include <functional>
 #include <future>
-#include <iostream>
 #include <memory>
 #include <tuple>
-#include <unordered_map>
+#include <vector>
+#include <workspace/arena.hpp>
 #include <workspace/autothread.hpp>
+#include <workspace/coroutine.hpp>
+#include <workspace/errors.hpp>
 #include <workspace/invoke.hpp>
+#include <workspace/metrics.hpp>
 #include <workspace/taskqueue.hpp>
+#include <workspace/tracing.hpp>
 #include <workspace/utility.hpp>
 
 
@@ -22,14 +28,76 @@ enum class waitstrategy {
                  // or conditions are met.
 };
 
+enum class shutdown_mode {
+    drain,    // run every queued task, then stop
+    discard,  // drop the queued tasks (their futures report broken_promise)
+    cancel    // skip the queued tasks, their futures throw task_cancelled
+};
+
 namespace details {
 
 struct cpu_multiple_tag_t {};
 constexpr cpu_multiple_tag_t cpu_multiple_tag{};
 
+class workbranch;
+
+// the workbranch worker running on the calling thread (see this_worker)
+struct worker_context {
+    constexpr static int max_nesting = 64;  // tasks run_pending_task may nest on one stack
+
+    workbranch* branch = nullptr;
+    size_t index = static_cast<size_t>(-1);  // slot of the worker in its branch
+    int nesting = 0;                         // tasks run_pending_task nested on this stack
+
+    static worker_context& local() {
+        thread_local worker_context ctx;
+        return ctx;
+    }
+};
+
+/**
+ * @brief Mark a section of a task that may block (disk, lock, remote call...)
+ *
+ * While the outermost region is alive the branch running the task starts a compensating worker,
+ * so its queue keeps draining. When the region ends that worker stays as a spare for the next region,
+ * and retires once the branch idled for a short while. Outside a worker thread, nested in another
+ * region, or past the branch's cap (see set_max_compensating) it does nothing.
+ */
+class blocking_region {
+    workbranch* br = nullptr;
+
+    static int& depth() {
+        thread_local int d = 0;
+        return d;
+    }
+
+    static bool& lent() {
+        thread_local bool l = false;  // the outermost region started a compensating worker
+        return l;
+    }
+
+public:
+    blocking_region();
+    ~blocking_region();
+    blocking_region(const blocking_region&) = delete;
+    blocking_region& operator=(const blocking_region&) = delete;
+
+    /**
+     * @brief whether a worker stands in for this thread (started by this region or an enclosing one)
+     */
+    bool compensated() const {
+        return lent();
+    }
+};
+
 class workbranch {
     friend class supervisor;
+    friend class blocking_region;
+    friend class shardspace;
     constexpr static int max_spin_count = 10000;
+    constexpr static size_t retired_ring_limit = 16;  // traces kept of deleted workers, oldest dropped first
+    constexpr static auto spare_linger = std::chrono::milliseconds(50);  // idle time before a spare worker retires
+    constexpr static auto destroy_timeout = std::chrono::seconds(60);    // see ~workbranch
 
     struct worker_state {
         std::atomic_bool deleting = false;
@@ -41,37 +109,109 @@ class workbranch {
         }
     };
 
-    class worker_entry {
-    public:
-        worker_entry() = default;
+    using worker_id = uintmax_t;
 
+    // state of one worker, aligned to cache lines so that workers never false-share
+    struct alignas(64) worker_slot {
         autothread thread;
-        std::atomic_bool busy = false;
-        std::chrono::steady_clock::time_point last_active_time;
+        worker_id id = 0;                         // unique, kept in trace events
+        size_t index = 0;                         // position in the table
+        bool used = false;                        // guarded by lok
+        std::atomic_bool busy{false};             // written by the owning worker only
+        std::atomic<int64_t> last_active{0};      // steady_clock ns of the last switch to idle
+        worker_metrics metrics;
+        worker_arena arena;                       // scratch memory, rewound after every task
+        std::atomic<trace_ring*> ring{nullptr};  // allocated while tracing
+        bool exited = false;                      // left during shutdown, to be joined (guarded by lok)
+
+        bool is_idle() const {
+            return !busy.load(std::memory_order_relaxed);
+        }
+
+        ~worker_slot() {
+            delete ring.load();
+        }
+    };
 
-        template <typename F, typename... Args>
-        worker_entry(F&& f, Args&&... args)
-          : busy(false)
-          , thread(std::forward<F>(f), std::forward<Args>(args)...)
-          , last_active_time(std::chrono::steady_clock::now()) {
+    /**
+     * @brief Worker slots in contiguous blocks with a free list (guarded by lok)
+     * @note blocks never move, so a worker keeps a plain reference to its slot; freed slots are
+     * reused before a new block is allocated
+     */
+    class worker_table {
+        constexpr static size_t block_size = 8;
+
+        std::vector<std::unique_ptr<worker_slot[]>> blocks;
+        std::vector<size_t> free_list;
+        std::atomic_size_t live{0};  // readable without the lock
+
+        void grow() {
+            auto first = blocks.size() * block_size;
+            blocks.emplace_back(new worker_slot[block_size]);
+            for (size_t i = block_size; i > 0; --i) {
+                blocks.back()[i - 1].index = first + i - 1;
+                free_list.push_back(first + i - 1);
+            }
         }
 
-        void mark_idle() {
-            busy = false;
-            last_active_time = std::chrono::steady_clock::now();
+    public:
+        // preallocate slots for n workers
+        void reserve(size_t n) {
+            while (blocks.size() * block_size < n) grow();
         }
 
-        void mark_busy() {
-            busy = true;
+        worker_slot& acquire() {
+            if (free_list.empty()) grow();
+            auto idx = free_list.back();
+            free_list.pop_back();
+            auto& slot = blocks[idx / block_size][idx % block_size];
+            slot.used = true;
+            live.fetch_add(1);
+            return slot;
         }
 
-        bool is_idle() const {
-            return !busy;
+        // free the slot and hand over its thread, which may still be returning
+        autothread release(worker_slot& slot) {
+            slot.used = false;
+            autothread thread(std::move(slot.thread));
+            free_list.push_back(slot.index);
+            live.fetch_sub(1);
+            return thread;
+        }
+
+        size_t size() const {
+            return live.load();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        template <typename F>
+        void for_each(F&& f) {
+            for (auto& block : blocks) {
+                for (size_t i = 0; i < block_size; ++i) {
+                    if (block[i].used) f(block[i]);
+                }
+            }
         }
     };
 
-    using worker_id = uintmax_t;
-    using worker_map = std::unordered_map<worker_id, worker_entry>;
+    // a queued task, the moment it was queued and its trace label
+    struct task_entry {
+        task_t fn;
+        std::chrono::steady_clock::time_point enqueued;
+        const char* label = nullptr;
+
+        task_entry() = default;
+
+        template <typename F, typename = typename std::enable_if<
+                                  !std::is_same<typename std::decay<F>::type, task_entry>::value>::type>
+        task_entry(F&& f)
+          : fn(std::forward<F>(f))
+          , label(trace_label::current()) {
+        }
+    };
 
     std::atomic<worker_id> worker_next_id = 0;
 
@@ -80,11 +220,41 @@ class workbranch {
     std::atomic_size_t idle_workers = 0;
     std::atomic_size_t resumed_workers = 0;
     std::atomic_size_t pending_deletions = 0;
+    std::atomic_size_t compensating = 0;  // workers added by blocking regions
+    std::atomic_size_t spare = 0;         // compensating workers whose region ended, kept for the next one
+    std::atomic<int64_t> spare_since{0};  // when the last region ended (ns)
+    size_t retiring = 0;                  // compensating workers asked to leave (guarded by lok)
+    size_t max_compensating = 64;         // guarded by lok
 
     worker_state worker_state;
 
-    worker_map workers;
-    taskqueue<task_t> tq;
+    worker_table workers;
+    taskqueue<task_entry> tq;
+
+    alignas(64) std::atomic<uint64_t> submitted{0};
+    alignas(64) std::atomic_size_t busy_workers{0};  // workers running a batch of tasks
+    branch_stats retired;  // metrics of deleted workers, plus spawned/exited counts (guarded by lok)
+
+    exception_sink errors;  // exceptions escaping void tasks
+
+    std::function<void()> start_hook;  // guarded by lok
+    std::function<void()> stop_hook;   // guarded by lok
+    std::atomic<uint64_t> start_version{0};
+    size_t leaving = 0;  // workers that took a deletion and run the stop hook (guarded by lok)
+    shutdown_mode stop_mode = shutdown_mode::discard;  // set before destructing
+    std::atomic_bool cancelling{false};                // queued tasks are skipped (shutdown_mode::cancel)
+
+    const uint64_t branch_id = next_branch_id();
+    std::atomic_bool tracing{false};
+    size_t trace_capacity = 0;
+    size_t arena_block = 64 * 1024;     // guarded by lok
+    size_t arena_retain = 1024 * 1024;  // guarded by lok
+    std::deque<std::unique_ptr<trace_ring>> retired_rings;  // traces of deleted workers (guarded by lok)
+    std::vector<autothread> retired_threads;  // workers deleted outside shutdown, not joined yet (guarded by lok)
+
+#if defined(WSP_HAS_COROUTINES)
+    frame_pool frames;  // coroutine frames created on the workers
+#endif
 
     std::mutex lok;
     std::condition_variable thread_cv;
@@ -94,6 +264,8 @@ class workbranch {
     std::condition_variable task_resume_cv;
 
     std::condition_variable task_deletion_cv;
+    std::condition_variable decline_cv;  // a deletion is free to take, or deleting ended
+    std::condition_variable exit_cv;     // every worker left during shutdown
 
 public:
     /**
@@ -103,6 +275,7 @@ public:
      */
     explicit workbranch(int wks = 1, waitstrategy strategy = waitstrategy::blocking) {
         wait_strategy = strategy;
+        workers.reserve(std::max(wks, 1));
         for (int i = 0; i < std::max(wks, 1); ++i) {
             add_worker();  // worker
         }
@@ -111,44 +284,94 @@ public:
     workbranch(const workbranch&) = delete;
     workbranch(workbranch&&) = delete;
 
+    /**
+     * @note shuts down with shutdown_mode::discard if shutdown() was not called, and joins every worker.
+     * It waits at most destroy_timeout (60s) for the running tasks, then calls std::terminate: like a
+     * joinable std::thread, a worker cannot outlive the branch it runs on. To allow longer tasks, call
+     * shutdown() with the timeout you need before the destructor. Destroying a branch from one of its own
+     * tasks terminates too, since that worker cannot join itself.
+     */
     ~workbranch() {
+        if (!shutdown(shutdown_mode::discard, destroy_timeout)) std::terminate();
+    }
+
+    /**
+     * @brief whether shutdown() has begun (also by the destructor)
+     */
+    bool is_shutdown() {
+        return worker_state.destructing.load();
+    }
+
+    /**
+     * @brief stop the workers and join them
+     * @param mode what happens to the queued tasks: drain, discard or cancel
+     * @param timeout how long to wait for the workers to finish their current task
+     * @return false on timeout: the workers still running are joined by a later call or the destructor
+     * @note tasks submitted once the shutdown has begun never run; only the first call picks the mode.
+     * Called from a task of this branch, it starts the shutdown and returns false without waiting.
+     */
+    bool shutdown(shutdown_mode mode = shutdown_mode::drain, std::chrono::milliseconds timeout = default_max_time) {
+        bool first = false;
         {
             std::lock_guard<std::mutex> lock(lok);
-            pending_deletions = workers.size();
-            worker_state.destructing.store(true);
-
-            if (wait_strategy == waitstrategy::blocking) {
-                task_cv.notify_all();
+            if (!worker_state.destructing.load()) {
+                first = true;
+                stop_mode = mode;
+                cancelling.store(mode == shutdown_mode::cancel);
+                pending_deletions = workers.size();
+                worker_state.destructing.store(true);
             }
+            task_cv.notify_all();
+            decline_cv.notify_all();
         }
-
-        bool res;
-        {
-            std::unique_lock<std::mutex> lock(lok);
-            res = thread_cv.wait_for(lock, std::chrono::seconds(1), [this] { return pending_deletions.load() == 0; });
+        if (first && mode == shutdown_mode::discard) {
+            tq.take_all();  // destroyed here, outside the queue lock: a dropped coroutine may submit again
         }
 
-        for (; !res;) {
-            if (pending_deletions > 0) {
-                std::lock_guard<std::mutex> lock(lok);
+        join_retired();
+        // a worker would wait for itself: it leaves once its current task returns
+        if (worker_context::local().branch == this) return false;
 
-                for (auto it = workers.begin(); it != workers.end();) {
-                    if (!it->second.thread.is_alive()) {
-                        it = workers.erase(it);
-                        --pending_deletions;
-                    } else {
-                        ++it;
-                    }
-                }
-            } else {
-                break;
-            }
-
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::unique_lock<std::mutex> lock(lok);
+        bool done = exit_cv.wait_until(lock, deadline_after(timeout), [this] { return pending_deletions.load() == 0; });
+        // workers that left return right away: joining them holds the lock only briefly
+        workers.for_each([this](worker_slot& worker) {
+            if (!worker.exited) return;
+            worker.thread.join();
+            worker.exited = false;
+            workers.release(worker);
+        });
+        lock.unlock();
+        if (done) {
+            tq.take_all();
         }
+        return done;
     }
 
 public:
+    /**
+     * @brief run one queued task on the calling worker, e.g. while its task waits for a result
+     * @return false if the queue is empty, if the caller is not a worker of this branch, or if it
+     * already nests worker_context::max_nesting tasks
+     * @note the task runs nested in the caller's task, on the same stack. It is the newest one: the
+     * children a task waits for are at the back, so recursive waits nest about as deep as the recursion
+     */
+    bool run_pending_task() {
+        auto& ctx = worker_context::local();
+        if (ctx.branch != this || ctx.nesting >= worker_context::max_nesting) return false;
+        if (worker_state.deleting.load() || !runs_queue()) return false;
+        task_entry task;
+        if (!tq.try_pop_back(task)) return false;  // most likely a task the waiting one just submitted
+        struct nested {
+            int& depth;
+            ~nested() {
+                --depth;
+            }
+        } guard{++ctx.nesting};
+        execute(*local_slot(), task, std::chrono::steady_clock::now());
+        return true;
+    }
+
     /**
      * @brief Wait for all tasks done.
      * @brief This interface will pause all threads(workers) in workbranch to
@@ -187,16 +410,85 @@ public:
         return res;
     }
 
+public:
+    using error_handler = exception_sink::handler_t;
+
+    /**
+     * @brief handle exceptions thrown by tasks that return void (tasks returning a value report
+     * through their std::future)
+     * @param handler called on the worker with each exception, calls are serialized; nullptr restores
+     * the default, which keeps them for drain_exceptions()
+     * @param max_per_second exceptions passed on per second, the rest are only counted (0 = unlimited)
+     */
+    void set_error_handler(error_handler handler, size_t max_per_second = exception_sink::default_rate) {
+        errors.set_handler(std::move(handler), max_per_second);
+    }
+
+    /**
+     * @brief set how many exceptions are kept for drain_exceptions() (oldest are dropped first)
+     * @param capacity 0 keeps none
+     */
+    void set_exception_capacity(size_t capacity) {
+        errors.set_capacity(capacity);
+    }
+
+    /**
+     * @brief take the exceptions collected since the last call
+     * @return oldest first
+     */
+    std::vector<std::exception_ptr> drain_exceptions() {
+        return errors.drain();
+    }
+
+public:
+    /**
+     * @brief run a callable on every worker before it takes its next task
+     * @param hook <void()>, runs once per worker (again on all of them if replaced); use this_worker to
+     * tell which worker it is; nullptr removes it
+     * @note workers started later run it first thing; exceptions go to the error handler
+     */
+    void on_worker_start(std::function<void()> hook) {
+        std::lock_guard<std::mutex> lock(lok);
+        start_hook = std::move(hook);
+        start_version.fetch_add(1);
+    }
+
+    /**
+     * @brief run a callable on every worker that leaves the branch (deleted or destructing)
+     * @param hook <void()>, nullptr removes it
+     * @note the branch waits for the hook before it finishes deleting the worker
+     */
+    void on_worker_stop(std::function<void()> hook) {
+        std::lock_guard<std::mutex> lock(lok);
+        stop_hook = std::move(hook);
+    }
+
 public:
     /**
      * @brief get number of workers
      * @return number
      */
     size_t num_workers() {
-        std::lock_guard<std::mutex> lock(lok);
         return workers.size();
     }
 
+    /**
+     * @brief get number of compensating workers started for tasks inside a blocking region
+     * @return number (included in num_workers)
+     */
+    size_t num_compensating() {
+        return compensating.load();
+    }
+
+    /**
+     * @brief cap the compensating workers that blocking regions may start
+     * @param num at most this many at once; regions entered beyond it do not compensate
+     */
+    void set_max_compensating(size_t num) {
+        std::lock_guard<std::mutex> lock(lok);
+        max_compensating = num;
+    }
+
     /**
      * @brief get number of tasks in the task queue
      * @return number
@@ -205,31 +497,116 @@ public:
         return tq.length();
     }
 
+    /**
+     * @brief get number of workers idle for at least timeout
+     * @note O(1) when every worker is busy, otherwise walks the slot table
+     */
     template <typename Rep, typename Period>
     size_t count_idle_workers(std::chrono::duration<Rep, Period> timeout) {
+        if (busy_workers.load(std::memory_order_relaxed) >= workers.size()) return 0;
+        auto limit = now_ns() - std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
         std::lock_guard<std::mutex> lock(lok);
         size_t count = 0;
-        auto now = std::chrono::steady_clock::now();
-        for (const auto& entry : workers) {
-            auto& worker = entry.second;
-            if (worker.is_idle() &&
-                std::chrono::duration_cast<std::chrono::milliseconds>(now - worker.last_active_time) >= timeout) {
-                ++count;
-            }
-        }
+        workers.for_each([&count, limit](const worker_slot& worker) {
+            if (worker.is_idle() && worker.last_active.load(std::memory_order_relaxed) <= limit) ++count;
+        });
         return count;
     }
 
-    size_t count_busy_workers() {
+    /**
+     * @brief snapshot of the branch metrics
+     * @return counters, utilisation and queue-wait/execution histograms (ns)
+     * @note workers record into their own padded slots without locking; the snapshot aggregates them
+     */
+    branch_stats stats() {
+        branch_stats st;
+        st.submitted = submitted.load(std::memory_order_relaxed);
+        st.queued = tq.length();
+        st.failed = errors.count();
+        st.suppressed = errors.count_suppressed();
+
         std::lock_guard<std::mutex> lock(lok);
-        size_t count = 0;
-        for (const auto& entry : workers) {
-            auto& worker = entry.second;
-            if (!worker.is_idle()) {
-                ++count;
-            }
+        auto now = std::chrono::steady_clock::now();
+        st.completed = retired.completed;
+        st.busy_ns = retired.busy_ns;
+        st.worker_ns = retired.worker_ns;
+        st.queue_wait.merge(retired.queue_wait);
+        st.execution.merge(retired.execution);
+        st.arena = retired.arena;
+        workers.for_each([&st, now](const worker_slot& worker) {
+            collect(worker.metrics, st, now);
+            worker.arena.collect(st.arena);
+        });
+        st.workers = workers.size();
+        st.spawned = retired.spawned;
+        st.exited = retired.exited;
+        return st;
+    }
+
+    /**
+     * @brief size the scratch arenas of the workers (see this_worker::arena())
+     * @param block_bytes size of the blocks taken from the heap
+     * @param retain_bytes bytes an arena keeps between tasks, the rest goes back to the heap
+     */
+    void set_arena_limits(size_t block_bytes, size_t retain_bytes) {
+        std::lock_guard<std::mutex> lock(lok);
+        arena_block = block_bytes;
+        arena_retain = retain_bytes;
+        workers.for_each([=](worker_slot& worker) { worker.arena.set_limits(block_bytes, retain_bytes); });
+    }
+
+    /**
+     * @brief start recording a trace event for every task
+     * @param capacity events kept per worker (older ones are overwritten)
+     * @note each worker writes into its own lock-free ring; workers added later get one too
+     */
+    void enable_tracing(size_t capacity = 1 << 16) {
+        std::lock_guard<std::mutex> lock(lok);
+        trace_capacity = capacity;
+        workers.for_each([capacity](worker_slot& worker) {
+            if (!worker.ring.load()) worker.ring.store(new trace_ring(capacity));
+        });
+        tracing.store(true);
+    }
+
+    /**
+     * @brief stop recording (events already recorded are kept)
+     */
+    void disable_tracing() {
+        tracing.store(false);
+    }
+
+    /**
+     * @brief collect the recorded trace events
+     * @return events of live workers and of the last 16 deleted ones, unordered
+     */
+    std::vector<trace_event> trace_events() {
+        std::vector<trace_event> events;
+        std::lock_guard<std::mutex> lock(lok);
+        for (auto& ring : retired_rings) {
+            ring->collect(events);
         }
-        return count;
+        workers.for_each([&events](worker_slot& worker) {
+            if (auto ring = worker.ring.load()) ring->collect(events);
+        });
+        return events;
+    }
+
+    /**
+     * @brief write the recorded trace events as a Chrome Trace / Perfetto JSON file
+     * @param path output file
+     * @return false if the file cannot be written
+     */
+    bool dump_trace(const std::string& path) {
+        return write_chrome_trace(path, trace_events());
+    }
+
+    /**
+     * @brief get number of workers running tasks
+     * @note O(1), read from a counter the workers keep up to date
+     */
+    size_t count_busy_workers() {
+        return busy_workers.load(std::memory_order_relaxed);
     }
 
 public:
@@ -257,16 +634,12 @@ public:
     template <typename T = normal, typename F, typename R = details::result_of_t<F>,
               typename DR = typename std::enable_if<std::is_void<R>::value>::type>
     auto submit(F&& task) -> typename std::enable_if<!std::is_same<T, sequence>::value>::type {
-        auto wrapper_task = [task = std::forward<F>(task)]() mutable {
+        auto wrapper_task = [this, task = std::forward<F>(task)]() mutable {
+            if (cancelling.load(std::memory_order_relaxed)) return;
             try {
                 task();
-            } catch (const std::exception& ex) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id()
-                          << "] caught exception:\n  what(): " << ex.what() << '\n'
-                          << std::flush;
             } catch (...) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id() << "] caught unknown exception\n"
-                          << std::flush;
+                errors.report(std::current_exception());
             }
         };
 
@@ -283,16 +656,12 @@ public:
      */
     template <typename T, typename F, typename... Fs>
     auto submit(F&& task, Fs&&... tasks) -> typename std::enable_if<std::is_same<T, sequence>::value>::type {
-        tq.push_back([=] {
+        add_task<normal>([this, task, tasks...] {
+            if (cancelling.load(std::memory_order_relaxed)) return;
             try {
                 this->rexec(task, tasks...);
-            } catch (const std::exception& ex) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id()
-                          << "] caught exception:\n  what(): " << ex.what() << '\n'
-                          << std::flush;
             } catch (...) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id() << "] caught unknown exception\n"
-                          << std::flush;
+                errors.report(std::current_exception());
             }
         });
         if (wait_strategy == waitstrategy::blocking) task_cv.notify_one();
@@ -308,18 +677,13 @@ public:
               typename DR = typename std::enable_if<!std::is_void<R>::value, R>::type,
               typename = typename std::enable_if<!std::is_same<T, sequence>::value>::type>
     auto submit(F&& task) -> std::future<R> {
-        auto task_ptr = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        auto task_ptr = std::make_shared<std::packaged_task<R()>>(cancellable<R>(std::forward<F>(task)));
         auto future = task_ptr->get_future();
-        auto wrapper_task = [task = std::move(task_ptr)] {
+        auto wrapper_task = [this, task = std::move(task_ptr)] {
             try {
                 (*task)();
-            } catch (const std::exception& ex) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id()
-                          << "] caught exception:\n  what(): " << ex.what() << '\n'
-                          << std::flush;
             } catch (...) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id() << "] caught unknown exception\n"
-                          << std::flush;
+                errors.report(std::current_exception());
             }
         };
 
@@ -329,6 +693,16 @@ public:
         return future;
     }
 
+#if defined(WSP_HAS_COROUTINES)
+    /**
+     * @brief resume the awaiting coroutine on a worker of this branch
+     * @return awaitable, use as `co_await branch.schedule()`
+     */
+    details::schedule_awaiter<workbranch> schedule() {
+        return {*this};
+    }
+#endif
+
     /**
      * @brief submit a task asynchronously and always return a std::future,
      *        even if the task returns void.
@@ -349,19 +723,14 @@ public:
         auto task_lambda = [func = std::forward<F>(task), args_tuple = std::move(args_tuple)]() mutable -> R {
             return invoke_hpp::apply(func, args_tuple);
         };
-        auto task_ptr = std::make_shared<std::packaged_task<R()>>(std::move(task_lambda));
+        auto task_ptr = std::make_shared<std::packaged_task<R()>>(cancellable<R>(std::move(task_lambda)));
         auto future = task_ptr->get_future();
 
-        auto wrapper_task = [task_ptr = std::move(task_ptr)] {
+        auto wrapper_task = [this, task_ptr = std::move(task_ptr)] {
             try {
                 (*task_ptr)();
-            } catch (const std::exception& ex) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id()
-                          << "] caught exception:\n  what(): " << ex.what() << '\n'
-                          << std::flush;
             } catch (...) {
-                std::cerr << "workspace: worker[" << std::this_thread::get_id() << "] caught unknown exception\n"
-                          << std::flush;
+                errors.report(std::current_exception());
             }
         };
 
@@ -373,28 +742,145 @@ public:
     }
 
 private:
+    // a task returning a future: once shutdown(shutdown_mode::cancel) started, the future throws task_cancelled
+    template <typename R, typename F>
+    auto cancellable(F&& task) {
+        return [this, task = std::forward<F>(task)]() mutable -> R {
+            if (cancelling.load(std::memory_order_relaxed)) throw task_cancelled();
+            return task();
+        };
+    }
+
     template <typename T, typename Task>
     typename std::enable_if<std::is_same<T, normal>::value>::type add_task(Task&& task) {
-        tq.push_back(std::forward<Task>(task));
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        tq.push_back(stamped(std::forward<Task>(task)));
     }
 
     template <typename T, typename Task>
-    typename std::enable_if<!std::is_same<T, normal>::value>::type add_task(Task&& task) {
-        tq.push_front(std::forward<Task>(task));
+    typename std::enable_if<std::is_same<T, blocking>::value>::type add_task(Task&& task) {
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        tq.push_back(stamped([task = std::forward<Task>(task)]() mutable {
+            blocking_region region;
+            task();
+        }));
+    }
+
+    template <typename T, typename Task>
+    typename std::enable_if<!std::is_same<T, normal>::value && !std::is_same<T, blocking>::value>::type add_task(
+        Task&& task) {
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        tq.push_front(stamped(std::forward<Task>(task)));
+    }
+
+    // queue entry stamped with the time it is queued (after wrapping and allocating the task)
+    template <typename Task>
+    static task_entry stamped(Task&& task) {
+        task_entry entry(std::forward<Task>(task));
+        entry.enqueued = std::chrono::steady_clock::now();
+        return entry;
+    }
+
+    // a task on this branch is about to block: keep the queue draining with one more worker,
+    // a spare one if a region ended recently
+    bool enter_blocking() {
+        std::lock_guard<std::mutex> lock(lok);
+        if (worker_state.destructing.load()) return false;
+        if (spare.load() > 0) {
+            --spare;
+            return true;
+        }
+        if (compensating.load() >= max_compensating) return false;
+        compensating.fetch_add(1);
+        spawn_worker();
+        return true;
+    }
+
+    // the blocking section is over: its worker stays as a spare until it idled for spare_linger
+    void exit_blocking() {
+        std::lock_guard<std::mutex> lock(lok);
+        if (worker_state.destructing.load()) return;
+        spare_since.store(now_ns(), std::memory_order_relaxed);
+        ++spare;
+    }
+
+    // called by an idle worker: retire one spare worker once the branch has had no use for it
+    void retire_spare(worker_slot& worker) {
+        auto since = std::max(worker.last_active.load(std::memory_order_relaxed),
+                              spare_since.load(std::memory_order_relaxed));
+        if (std::chrono::nanoseconds(now_ns() - since) < spare_linger) return;
+        join_retired();  // the spares retired before this one
+        std::lock_guard<std::mutex> lock(lok);
+        if (spare.load() == 0 || worker_state.destructing.load()) return;
+        --spare;
+        ++retiring;
+        ++pending_deletions;
+        worker_state.deleting.store(true);
+        decline_cv.notify_all();
+        if (wait_strategy == waitstrategy::blocking) {
+            task_cv.notify_all();
+        }
+    }
+
+    static void collect(const worker_metrics& m, branch_stats& st, std::chrono::steady_clock::time_point now) {
+        st.completed += m.completed.load(std::memory_order_relaxed);
+        st.busy_ns += m.busy_ns.load(std::memory_order_relaxed);
+        st.worker_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - m.born).count();
+        m.queue_wait.collect(st.queue_wait);
+        m.execution.collect(st.execution);
+    }
+
+    // steady_clock deadline, saturated for "forever" timeouts
+    static std::chrono::steady_clock::time_point deadline_after(std::chrono::milliseconds timeout) {
+        auto now = std::chrono::steady_clock::now();
+        if (timeout >= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::time_point::max() - now)) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return now + timeout;
+    }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void mark_busy(worker_slot& worker) {
+        worker.busy.store(true, std::memory_order_relaxed);
+        busy_workers.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void mark_idle(worker_slot& worker) {
+        worker.last_active.store(now_ns(), std::memory_order_relaxed);
+        worker.busy.store(false, std::memory_order_relaxed);
+        busy_workers.fetch_sub(1, std::memory_order_relaxed);
     }
 
     /**
      * @brief add one worker
-     * @note O(logN)
+     * @note O(1), reuses a free slot when there is one
      */
     void add_worker(size_t num = 1) {
+        join_retired();
         std::lock_guard<std::mutex> lock(lok);
+        if (worker_state.destructing.load()) return;
         for (size_t i = 0; i < num; i++) {
-            auto worker_id = worker_next_id.fetch_add(1);
-            workers.try_emplace(worker_id, &workbranch::mission, this, worker_id);
+            spawn_worker();
         }
     }
 
+    // start a worker in a free slot (lok held)
+    void spawn_worker() {
+        auto& worker = workers.acquire();
+        worker.id = worker_next_id.fetch_add(1);
+        worker.metrics.reset();  // a reused slot still holds the counters and birth of its last worker
+        worker.last_active.store(now_ns(), std::memory_order_relaxed);
+        worker.arena.set_limits(arena_block, arena_retain);
+        if (tracing.load()) worker.ring.store(new trace_ring(trace_capacity));
+        worker.thread = std::thread(&workbranch::mission, this, std::ref(worker));
+        ++retired.spawned;
+    }
+
     /**
      * @brief delete one worker
      * @note O(1)
@@ -402,7 +888,7 @@ private:
     void del_worker(size_t num = 1) {
         {
             std::lock_guard<std::mutex> lock(lok);
-            if (workers.empty() || workers.size() < num) {
+            if (worker_state.destructing.load() || workers.empty() || workers.size() < num) {
                 return;
             }
         }
@@ -418,6 +904,19 @@ private:
         task_deletion_cv.wait(lock, [this] { return pending_deletions == 0; });
 
         worker_state.deleting.store(false);
+        decline_cv.notify_all();
+        lock.unlock();
+        join_retired();
+    }
+
+    // join the workers deleted outside shutdown (never under lok: they may still be returning)
+    void join_retired() {
+        std::vector<autothread> threads;
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            threads.swap(retired_threads);
+        }
+        for (auto& each : threads) each.join();
     }
 
     void wait_for_task(int& spin_count) {
@@ -438,31 +937,97 @@ private:
             }
             case waitstrategy::blocking: {
                 std::unique_lock<std::mutex> locker(lok);
-                task_cv.wait(locker, [this] { return num_tasks() > 0 || worker_state.updated(); });
+                auto pred = [this] { return num_tasks() > 0 || worker_state.updated(); };
+                if (spare.load() > 0) {
+                    task_cv.wait_for(locker, spare_linger, pred);  // wake up to retire the spare
+                } else {
+                    task_cv.wait(locker, pred);
+                }
                 break;
             }
         }
     }
 
-    bool check_declining(worker_id id) {
-        std::lock_guard<std::mutex> lock(lok);
-        if (pending_deletions.load() > 0) {
-            --pending_deletions;
-            workers.erase(id);
-            if (worker_state.waiting.load()) {
-                task_idle_cv.notify_one();
-            }
-            if (worker_state.destructing.load()) {
-                thread_cv.notify_one();
+    // run a start/stop hook on this worker, reporting its exception like a task's
+    void run_hook(const std::function<void()>& hook) {
+        if (!hook) return;
+        try {
+            hook();
+        } catch (...) {
+            errors.report(std::current_exception());
+        }
+    }
+
+    // run the start hook if it changed since the worker last ran it
+    void check_start_hook(uint64_t& seen) {
+        if (start_version.load(std::memory_order_relaxed) == seen) return;
+        std::function<void()> hook;
+        {
+            std::lock_guard<std::mutex> lock(lok);
+            seen = start_version.load();
+            hook = start_hook;
+        }
+        run_hook(hook);
+    }
+
+    bool check_declining(worker_slot& worker) {
+        std::function<void()> hook;
+        {
+            std::unique_lock<std::mutex> lock(lok);
+            if (pending_deletions.load() <= leaving) {
+                // the deletions are taken by workers still leaving: wait for them instead of spinning
+                decline_cv.wait(lock, [this] {
+                    return pending_deletions.load() > leaving ||
+                           (!worker_state.deleting.load() && !worker_state.destructing.load());
+                });
+                return false;
             }
-            task_deletion_cv.notify_one();
-            return true;
+            ++leaving;  // this worker takes one deletion
+            hook = stop_hook;
         }
+        run_hook(hook);
 
-        return false;
+        std::lock_guard<std::mutex> lock(lok);
+        --leaving;
+        --pending_deletions;
+        if (!worker.is_idle()) mark_idle(worker);
+        collect(worker.metrics, retired, std::chrono::steady_clock::now());
+        worker.metrics.reset();
+        worker.arena.release();
+        worker.arena.collect(retired.arena);
+        worker.arena.reset_stats();
+        if (auto ring = worker.ring.exchange(nullptr)) {
+            retired_rings.emplace_back(ring);
+            if (retired_rings.size() > retired_ring_limit) retired_rings.pop_front();  // compensating workers come and go
+        }
+        if (worker_state.destructing.load()) {
+            worker.exited = true;  // shutdown() joins the thread
+        } else {
+            retired_threads.emplace_back(workers.release(worker));  // joined by join_retired()
+        }
+        ++retired.exited;
+        if (retiring > 0) {
+            --retiring;
+            compensating.fetch_sub(1);
+        } else if (spare.load() > 0) {
+            --spare;  // a supervisor deletion takes an idle spare first, or the count would outlive the workers
+            compensating.fetch_sub(1);
+        }
+        if (pending_deletions.load() == 0 && !worker_state.destructing.load()) {
+            worker_state.deleting.store(false);  // nobody waits on deletions started by retire_spare
+        }
+        decline_cv.notify_all();
+        if (worker_state.waiting.load()) {
+            task_idle_cv.notify_one();
+        }
+        if (worker_state.destructing.load() && pending_deletions.load() == 0) {
+            exit_cv.notify_all();
+        }
+        task_deletion_cv.notify_one();
+        return true;
     }
 
-    void wait_resume(worker_id id) {
+    void wait_resume() {
         std::unique_lock<std::mutex> lock(lok);
         idle_workers.fetch_add(1, std::memory_order_relaxed);
         task_idle_cv.notify_one();
@@ -473,27 +1038,62 @@ private:
         task_resume_cv.notify_one();
     }
 
+    // false once a shutdown drops the queue; drain and cancel still pop every task
+    bool runs_queue() {
+        return !worker_state.destructing.load() || stop_mode != shutdown_mode::discard;
+    }
+
+    // run a task taken from the queue at `dequeued`, with its metrics and trace event
+    void execute(worker_slot& worker, task_entry& task, std::chrono::steady_clock::time_point dequeued) {
+        auto traced = tracing.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        task.fn();
+        auto end = std::chrono::steady_clock::now();
+        worker.metrics.record(std::chrono::duration_cast<std::chrono::nanoseconds>(start - task.enqueued).count(),
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        if (traced) trace(worker, task, dequeued, start, end);
+    }
+
+    // slot of the worker running on the calling thread
+    static worker_slot*& local_slot() {
+        thread_local worker_slot* slot = nullptr;
+        return slot;
+    }
+
     // thread's default loop
-    void mission(worker_id id) {
-        task_t task;
+    void mission(worker_slot& worker) {
+        task_entry task;
         int spin_count = 0;
+        uint64_t hooks_seen = 0;
 
-        lok.lock();
-        worker_entry& worker = workers[id];
-        lok.unlock();
+        auto& ctx = worker_context::local();
+        ctx.branch = this;
+        ctx.index = worker.index;
+        local_slot() = &worker;
+        worker_arena::scope arena_scope(&worker.arena);
+#if defined(WSP_HAS_COROUTINES)
+        frame_pool::scope frame_scope(&frames);
+#endif
 
 
         while (true) {
             while (true) {
-                if (worker_state.destructing.load() || worker_state.deleting.load()) {
-                    if (check_declining(id)) {
+                check_start_hook(hooks_seen);
+                if (worker_state.deleting.load() || !runs_queue()) {
+                    if (check_declining(worker)) {
                         return;
                     }
                 } else if (tq.try_pop(task)) {
+                    auto dequeued = std::chrono::steady_clock::now();
                     if (worker.is_idle()) {
-                        worker.mark_busy();
+                        mark_busy(worker);
+                    }
+                    execute(worker, task, dequeued);
+                    worker.arena.reset();
+                } else if (worker_state.destructing.load()) {
+                    if (check_declining(worker)) {  // the queue is drained
+                        return;
                     }
-                    task();
                 } else {
                     break;
                 }
@@ -501,18 +1101,35 @@ private:
 
             if (!worker.is_idle()) {
                 spin_count = 0;
-                worker.mark_idle();
+                mark_idle(worker);
             }
+            if (spare.load(std::memory_order_relaxed) > 0) retire_spare(worker);
 
 
             if (worker_state.waiting.load()) {
-                wait_resume(id);
+                wait_resume();
             } else {
                 wait_for_task(spin_count);
             }
         }
     }
 
+    static uint64_t next_branch_id() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1);
+    }
+
+    void trace(worker_slot& worker, const task_entry& task, std::chrono::steady_clock::time_point dequeued,
+               std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        auto ring = worker.ring.load(std::memory_order_acquire);
+        if (!ring) return;
+        using std::chrono::nanoseconds;
+        auto ns = [](std::chrono::steady_clock::time_point tp) {
+            return std::chrono::duration_cast<nanoseconds>(tp.time_since_epoch()).count();
+        };
+        ring->push(trace_event{task.label, branch_id, worker.id, ns(task.enqueued), ns(dequeued), ns(start), ns(end)});
+    }
+
     // recursive execute
     template <typename F>
     void rexec(F&& func) {
@@ -527,5 +1144,103 @@ private:
     }
 };
 
+inline blocking_region::blocking_region() {
+    auto cur = worker_context::local().branch;
+    if (cur && depth()++ == 0 && cur->enter_blocking()) {
+        br = cur;
+        lent() = true;
+    }
+}
+
+inline blocking_region::~blocking_region() {
+    if (worker_context::local().branch) --depth();
+    if (br) {
+        lent() = false;
+        br->exit_blocking();
+    }
+}
+
+/**
+ * @brief wait until ready() holds; on a workbranch worker, run the queued tasks of its branch meanwhile
+ *
+ * A task waiting for the result of a task queued behind it on the same branch runs that task itself
+ * instead of holding its worker, so recursive divide and conquer cannot deadlock the branch. When the
+ * queue is empty, or the worker already nests worker_context::max_nesting tasks on its stack, it spins
+ * briefly, then calls block() inside a blocking_region. If the region gets no compensating worker (the
+ * branch is at its cap) it keeps polling and helping instead, since nobody else may run the queue.
+ * @param ready <bool()> polled between tasks
+ * @param block <void()> returns once ready() holds
+ */
+template <typename Ready, typename Block>
+void help_until(Ready ready, Block block) {
+    constexpr int spin_limit = 32;
+    auto br = worker_context::local().branch;
+    if (br) {
+        for (int idle = 0; !ready();) {
+            if (br->run_pending_task()) {
+                idle = 0;
+            } else if (++idle < spin_limit) {
+                std::this_thread::yield();
+            } else {
+                blocking_region region;  // tasks queued from now on go to a compensating worker
+                if (region.compensated()) {
+                    block();
+                    return;
+                }
+                idle = 0;
+            }
+        }
+        return;
+    }
+    block();
+}
+
+/**
+ * @brief wait for a future, helping like help_until
+ * @param fut std::future or std::shared_future
+ */
+template <typename Future>
+void help_wait(const Future& fut) {
+    help_until(
+        [&fut] {
+            // a deferred future runs in wait()
+            return fut.wait_for(std::chrono::seconds(0)) != std::future_status::timeout;
+        },
+        [&fut] { fut.wait(); });
+}
+
+/**
+ * @brief wait until ready() holds; lend the worker to a compensating one first, help only past the cap
+ *
+ * Unlike help_until it calls block() inside a blocking_region straight away, and runs queued tasks on
+ * its own stack only when the region gets no compensating worker: a task nested above a waiter may wait
+ * for that very waiter (a producer on a full channel its consumer would drain). Past the branch's cap
+ * nobody else may run the queue, so it polls and helps, retrying the region whenever the queue is empty.
+ * @param ready <bool()> polled between tasks
+ * @param block <void()> returns once ready() holds
+ */
+template <typename Ready, typename Block>
+void lend_until(Ready ready, Block block) {
+    constexpr int spin_limit = 32;
+    auto br = worker_context::local().branch;
+    while (!ready()) {
+        {
+            blocking_region region;
+            if (!br || region.compensated()) {
+                block();
+                return;
+            }
+        }
+        for (int idle = 0; idle < spin_limit && !ready();) {
+            if (br->run_pending_task()) {
+                idle = 0;
+            } else {
+                ++idle;
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
 }  // namespace details
 }  // namespace wsp
\ No newline at end of file
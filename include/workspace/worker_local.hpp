@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <workspace/metrics.hpp>
+#include <workspace/workbranch.hpp>
+
+namespace wsp {
+namespace details {
+
+/**
+ * @brief One T per worker of a workbranch, each on its own cache lines
+ *
+ * Slots are indexed by this_worker::index() and allocated in blocks of growing size, so local() is a
+ * thread-local read plus two loads and never takes a lock. Use it to shard counters or caches instead
+ * of sharing atomics between workers; initialise the slots from on_worker_start if needed.
+ * @tparam T default constructible
+ * @note a slot outlives its worker and is handed to the next worker with the same index
+ */
+template <typename T>
+class worker_local {
+    struct alignas(64) cell {
+        T value{};
+    };
+
+    constexpr static size_t first_block = 8;  // block b holds first_block << b cells
+    constexpr static size_t max_blocks = 48;
+
+    workbranch* br;
+    std::atomic<cell*> blocks[max_blocks];
+
+    // block holding a slot, and the slot's position inside it
+    static size_t locate(size_t idx, size_t& offset) {
+        auto b = static_cast<size_t>(log2_floor(idx / first_block + 1));
+        offset = idx - first_block * ((size_t(1) << b) - 1);
+        return b;
+    }
+
+    cell* block(size_t b) {
+        auto p = blocks[b].load(std::memory_order_acquire);
+        if (p) return p;
+        auto fresh = new cell[first_block << b];
+        if (blocks[b].compare_exchange_strong(p, fresh, std::memory_order_acq_rel)) return fresh;
+        delete[] fresh;  // another worker was first
+        return p;
+    }
+
+public:
+    /**
+     * @param branch workbranch whose workers use the slots
+     */
+    explicit worker_local(workbranch& branch)
+      : br(&branch) {
+        for (auto& each : blocks) each.store(nullptr, std::memory_order_relaxed);
+    }
+
+    worker_local(const worker_local&) = delete;
+    worker_local& operator=(const worker_local&) = delete;
+
+    ~worker_local() {
+        for (auto& each : blocks) delete[] each.load();
+    }
+
+    /**
+     * @brief slot of the calling worker
+     * @note throws std::logic_error if the caller is not a worker of the branch
+     */
+    T& local() {
+        auto& ctx = worker_context::local();
+        if (ctx.branch != br) throw std::logic_error("wsp::worker_local: not called on a worker of its branch");
+        return at(ctx.index);
+    }
+
+    /**
+     * @brief slot of a worker index
+     */
+    T& at(size_t idx) {
+        size_t offset;
+        auto b = locate(idx, offset);
+        return block(b)[offset].value;
+    }
+
+    /**
+     * @brief visit every slot allocated so far (slots of indices never used hold a default T)
+     * @param f <void(T&)>
+     * @note reading while workers write needs T to be atomic, or the workers to be quiet (e.g. after
+     * wait_tasks)
+     */
+    template <typename F>
+    void for_each(F&& f) {
+        for (size_t b = 0; b < max_blocks; ++b) {
+            auto p = blocks[b].load(std::memory_order_acquire);
+            if (!p) continue;
+            for (size_t i = 0; i < (first_block << b); ++i) f(p[i].value);
+        }
+    }
+};
+
+}  // namespace details
+}  // namespace wsp
@@ -1,12 +1,31 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
+#include <workspace/channel.hpp>
+#include <workspace/dispatch.hpp>
 #include <workspace/dynbranch.hpp>
+#if defined(__unix__) || defined(__APPLE__)
+#include <workspace/iobranch.hpp>
+#endif
+#if defined(__linux__)
+#include <workspace/reactor.hpp>
+#endif
+#include <workspace/parallel.hpp>
+#include <workspace/pipeline.hpp>
+#include <workspace/shardspace.hpp>
+#include <workspace/snapshot.hpp>
+#include <workspace/strand.hpp>
 #include <workspace/supervisor.hpp>
+#include <workspace/task_group.hpp>
+#include <workspace/this_worker.hpp>
+#include <workspace/wait.hpp>
 #include <workspace/workbranch.hpp>
+#include <workspace/worker_local.hpp>
 
 
 // public
@@ -20,6 +39,8 @@ using urg = details::urgent;
 using nor = details::normal;
 // Can be executed by a thread at a time
 using seq = details::sequence;
+// May block: the branch starts a compensating worker while it runs
+using blk = details::blocking;
 }  // namespace task
 
 // std::future collector
@@ -30,12 +51,56 @@ using workbranch = details::workbranch;
 // workbranch supervisor
 using supervisor = details::supervisor;
 using dynbranch = details::dynbranch;
+// Mark a blocking section inside a task
+using blocking_region = details::blocking_region;
+// Serial executor on top of a workbranch/dynbranch/workspace
+using strand = details::strand;
+// MPMC channel between tasks, and select over several of them
+template <typename T>
+using channel = details::channel<T>;
+using selector = details::selector;
+// Streaming stages over a bounded number of items
+template <typename T>
+using pipeline = details::pipeline<T>;
+// One pinned single-worker branch per core, with lock-free lanes between them
+using shardspace = details::shardspace;
+// Tasks waited for together, cancelled on the first error
+using task_group = details::task_group;
+using task_group_error = details::task_group_error;
+// Set on the futures of tasks skipped by shutdown(shutdown_mode::cancel)
+using task_cancelled = details::task_cancelled;
+// Metrics snapshot of a workbranch
+using branch_stats = details::branch_stats;
+using histogram_snapshot = details::histogram_snapshot;
+// Per-worker scratch memory (see this_worker::arena())
+using worker_arena = details::worker_arena;
+using arena_stats = details::arena_stats;
+// One value per worker of a workbranch (see this_worker::index())
+template <typename T>
+using worker_local = details::worker_local<T>;
+// Task tracing
+using trace_event = details::trace_event;
+using trace_label = details::trace_label;
+#if defined(__unix__) || defined(__APPLE__)
+// Asynchronous file I/O (io_uring or I/O threads)
+using iobranch = details::iobranch;
+#endif
+#if defined(__linux__)
+// epoll readiness events dispatched onto workbranches
+using reactor = details::reactor;
+#endif
+#if defined(WSP_HAS_COROUTINES)
+// Lazy coroutine (C++20), named co_task since wsp::task holds the task tags
+template <typename T = void>
+using co_task = details::co_task<T>;
+#endif
 
 }  // namespace wsp
 
 namespace wsp {
 
 // Component manager
+// submit (from any number of threads) is lock-free; attach/detach may run while tasks flow
 class workspace {
 public:
     class bid {
@@ -85,19 +150,50 @@ public:
         }
     };
 
+    // user-supplied dispatch policy: returns the index of the branch that receives the task
+    // (called concurrently when several threads submit)
+    using dispatch_policy = details::dispatcher::policy_fn;
+
 private:
+    constexpr static size_t keyed_strands = 64;  // keys are hashed onto this many strands
+
     using branch_lst = std::list<std::unique_ptr<workbranch>>;
     using superv_map = std::unordered_map<const supervisor*, std::unique_ptr<supervisor>>;
-    using pos_t = branch_lst::iterator;
+    using route_t = details::snapshot<std::vector<workbranch*>>;
 
-    pos_t cur = {};
+    std::mutex lok;  // guards branches and supervs (ownership), never taken by submit
     branch_lst branches;
+    route_t route;  // dispatch candidates, republished on attach/detach
     superv_map supervs;
+    details::dispatcher dispatcher;
+    std::vector<strand> strands;  // for submit_keyed
 
 public:
-    explicit workspace() = default;
+    /**
+     * @brief construct a workspace
+     * @param how how tasks are dispatched among workbranches (defaults to adjacent)
+     */
+    explicit workspace(dispatch how = dispatch::adjacent)
+      : dispatcher(how) {
+        init_strands();
+    }
+
+    /**
+     * @brief construct a workspace with a user-supplied dispatch policy
+     * @param policy returns the index of the workbranch that receives the task
+     */
+    explicit workspace(dispatch_policy policy)
+      : dispatcher(std::move(policy)) {
+        init_strands();
+    }
 
     ~workspace() {
+        for (auto& each : strands) {
+            each.close();  // stop draining before the branches go away
+        }
+        std::lock_guard<std::mutex> lock(lok);
+        // no submit may pick a branch once its destruction begins
+        route.update([](std::vector<workbranch*>& brs) { brs.clear(); });
         supervs.clear();
         branches.clear();
     }
@@ -109,12 +205,13 @@ public:
      * @brief attach a workbranch
      * @param br ptr (heap memory)
      * @return id
-     * @note O(1)
+     * @note O(n), safe to call while other threads submit
      */
     bid attach(workbranch* br) {
         assert(br != nullptr);
+        std::lock_guard<std::mutex> lock(lok);
         branches.emplace_back(br);
-        cur = branches.begin();  // reset cursor
+        route.update([br](std::vector<workbranch*>& brs) { brs.push_back(br); });
         return bid(br);
     }
     /**
@@ -125,6 +222,7 @@ public:
      */
     sid attach(supervisor* sp) {
         assert(sp != nullptr);
+        std::lock_guard<std::mutex> lock(lok);
         supervs.emplace(sp, std::unique_ptr<supervisor>(sp));
         return sid(sp);
     }
@@ -133,12 +231,16 @@ public:
      * @brief detach workbranch by id
      * @param id branch's id
      * @return std::unique_ptr<workbranch>
-     * @note O(n)
+     * @note O(n), safe to call while other threads submit: returns once no submit can still pick the branch.
+     * Tasks already queued on the branch go with it.
      */
     auto detach(bid id) -> std::unique_ptr<workbranch> {
+        std::lock_guard<std::mutex> lock(lok);
         for (auto it = branches.begin(); it != branches.end(); it++) {
             if (it->get() == id.base) {
-                if (cur == it) forward(cur);
+                route.update([&id](std::vector<workbranch*>& brs) {
+                    brs.erase(std::find(brs.begin(), brs.end(), id.base));
+                });
                 auto ptr = it->release();
                 branches.erase(it);
                 return std::unique_ptr<workbranch>(ptr);
@@ -154,6 +256,7 @@ public:
      * @note O(logn)
      */
     auto detach(sid id) -> std::unique_ptr<supervisor> {
+        std::lock_guard<std::mutex> lock(lok);
         auto it = supervs.find(id.base);
         if (it == supervs.end()) {
             return nullptr;
@@ -167,18 +270,36 @@ public:
     /**
      * @brief travel all the workbranchs and deal each of them
      * @param deal <void(workbranch&)> how to deal with the work branch
+     * @note attach/detach wait until the travel ends, so do not call them in deal
      */
     void for_each(std::function<void(workbranch&)> deal) {
-        for (auto& each : branches) {
-            deal(*(each.get()));
+        auto snap = route.read();
+        for (auto each : *snap) {
+            deal(*each);
         }
     }
 
+    /**
+     * @brief write the trace events of all workbranches as one Chrome Trace / Perfetto JSON file
+     * @param path output file
+     * @return false if the file cannot be written
+     * @note enable tracing on the branches first (workbranch::enable_tracing)
+     */
+    bool dump_trace(const std::string& path) {
+        std::vector<trace_event> events;
+        for_each([&events](workbranch& each) {
+            auto part = each.trace_events();
+            events.insert(events.end(), part.begin(), part.end());
+        });
+        return details::write_chrome_trace(path, events);
+    }
+
     /**
      * @brief travel all the supervisors and deal each them
      * @param deal <void(supervisor&)> how to deal with the supervisor
      */
     void for_each(std::function<void(supervisor&)> deal) {
+        std::lock_guard<std::mutex> lock(lok);
         for (auto& each : supervs) {
             deal(*(each.second.get()));
         }
@@ -232,14 +353,8 @@ public:
     template <typename T = task::nor, typename F, typename... Args, typename R = details::result_of_t<F, Args...>,
               typename DR = typename std::enable_if<std::is_void<R>::value>::type>
     void submit(F&& task, Args&&... args) {
-        assert(branches.size() > 0);
-        auto this_br = cur->get();
-        auto next_br = forward(cur)->get();
-        if (next_br->num_tasks() < this_br->num_tasks()) {
-            next_br->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        } else {
-            this_br->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        }
+        auto snap = route.read();
+        next_branch(*snap)->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
     }
 
     /**
@@ -252,14 +367,8 @@ public:
     template <typename T = task::nor, typename F, typename... Args, typename R = details::result_of_t<F, Args...>,
               typename DR = typename std::enable_if<!std::is_void<R>::value, R>::type>
     auto submit(F&& task, Args&&... args) -> std::future<R> {
-        assert(branches.size() > 0);
-        auto this_br = cur->get();
-        auto next_br = forward(cur)->get();
-        if (next_br->num_tasks() < this_br->num_tasks()) {
-            return next_br->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        } else {
-            return this_br->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        }
+        auto snap = route.read();
+        return next_branch(*snap)->submit<T>(std::forward<F>(task), std::forward<Args>(args)...);
     }
 
     /**
@@ -276,14 +385,8 @@ public:
     template <typename T = task::nor, typename F, typename... Args, typename R = details::result_of_t<F, Args...>,
               typename DR = typename std::enable_if<!std::is_void<R>::value, R>::type>
     auto submit_future(F&& task, Args&&... args) -> std::future<R> {
-        assert(branches.size() > 0);
-        auto this_br = cur->get();
-        auto next_br = forward(cur)->get();
-        if (next_br->num_tasks() < this_br->num_tasks()) {
-            return next_br->submit_future<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        } else {
-            return this_br->submit_future<T>(std::forward<F>(task), std::forward<Args>(args)...);
-        }
+        auto snap = route.read();
+        return next_branch(*snap)->submit_future<T>(std::forward<F>(task), std::forward<Args>(args)...);
     }
 
     /**
@@ -293,22 +396,48 @@ public:
      */
     template <typename T, typename F, typename... Fs>
     auto submit(F&& task, Fs&&... tasks) -> typename std::enable_if<std::is_same<T, task::seq>::value>::type {
-        assert(branches.size() > 0);
-        auto this_br = cur->get();
-        auto next_br = forward(cur)->get();
-        if (next_br->num_tasks() < this_br->num_tasks()) {
-            return next_br->submit<T>(std::forward<F>(task), std::forward<Fs>(tasks)...);
-        } else {
-            return this_br->submit<T>(std::forward<F>(task), std::forward<Fs>(tasks)...);
-        }
+        auto snap = route.read();
+        return next_branch(*snap)->submit<T>(std::forward<F>(task), std::forward<Fs>(tasks)...);
+    }
+
+#if defined(WSP_HAS_COROUTINES)
+    /**
+     * @brief resume the awaiting coroutine on one of the workbranches
+     * @return awaitable, use as `co_await spc.schedule()`
+     */
+    details::schedule_awaiter<workspace> schedule() {
+        return {*this};
+    }
+#endif
+
+    /**
+     * @brief async execute a task after every task previously submitted with the same key
+     * @param key ordering key (e.g. a session id), must be hashable by std::hash
+     * @param task runnable object
+     * @param args arguments for the task
+     * @return void or std::future<R>
+     * @note tasks of one key never run concurrently and keep their submission order; they may
+     * run on any workbranch. Keys are hashed onto a fixed set of strands, so unrelated keys can
+     * occasionally share one and be serialized together.
+     */
+    template <typename K, typename F, typename... Args>
+    auto submit_keyed(const K& key, F&& task, Args&&... args) -> auto {
+        auto& str = strands[std::hash<K>()(key) % strands.size()];
+        return str.submit(std::forward<F>(task), std::forward<Args>(args)...);
     }
 
 private:
-    const pos_t& forward(pos_t& this_pos) {
-        if (++this_pos == branches.end()) {
-            this_pos = branches.begin();
+    void init_strands() {
+        strands.reserve(keyed_strands);
+        for (size_t i = 0; i < keyed_strands; ++i) {
+            strands.emplace_back(*this);
         }
-        return this_pos;
+    }
+
+    // choose a workbranch according to the dispatch policy
+    workbranch* next_branch(const std::vector<workbranch*>& brs) {
+        assert(brs.size() > 0);
+        return dispatcher.pick(brs);
     }
 };
 
@@ -0,0 +1,36 @@
+#include <cassert>
+#include <cstring>
+#include <workspace/workspace.hpp>
+
+int main() {
+    wsp::workbranch br(2);
+    br.set_arena_limits(4096, 64 * 1024);
+
+    // scratch memory inside tasks, rewound after each of them
+    for (int i = 0; i < 1000; ++i) {
+        br.submit([] {
+            auto& arena = wsp::this_worker::arena();
+            auto buf = static_cast<char*>(arena.allocate(1000));
+            std::memset(buf, 'x', 1000);
+            auto nums = static_cast<double*>(arena.allocate(100 * sizeof(double), alignof(double)));
+            nums[99] = 1.0;
+#if defined(WSP_HAS_PMR)
+            std::pmr::vector<int> v(&arena);
+            for (int k = 0; k < 100; ++k) v.push_back(k);
+#endif
+        });
+    }
+    br.wait_tasks();
+
+    auto st = br.stats().arena;
+    std::cout << "allocated: " << st.allocated << " | blocks: " << st.blocks << " | resets: " << st.resets
+              << " | peak: " << st.peak << " | retained: " << st.retained << std::endl;
+    assert(st.resets == 1000);
+    assert(st.blocks < 20);  // blocks are reused across tasks
+    assert(st.retained <= 64 * 1024);
+
+    // outside a worker: a thread-local arena rewound by hand
+    auto& own = wsp::this_worker::arena();
+    own.allocate(128);
+    own.reset();
+}
@@ -0,0 +1,58 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    // two workers, both stuck in blocking tasks: quick tasks still run
+    wsp::workbranch br(2);
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    br.submit<wsp::task::blk>([gate] { gate.wait(); });
+    br.submit([gate] {
+        wsp::blocking_region region;
+        gate.wait();
+    });
+
+    std::atomic_int quick{0};
+    for (int i = 0; i < 100; ++i) {
+        br.submit([&quick] { ++quick; });
+    }
+    while (quick.load() < 100) std::this_thread::yield();
+    std::cout << "workers while blocked: " << br.num_workers() << " (compensating: " << br.num_compensating() << ")"
+              << std::endl;
+    assert(br.num_compensating() == 2);
+
+    // the compensating workers retire once the regions end
+    release.set_value();
+    br.wait_tasks();
+    while (br.num_workers() != 2) std::this_thread::yield();
+    assert(br.num_compensating() == 0);
+    std::cout << "workers after: " << br.num_workers() << std::endl;
+
+    // back-to-back regions reuse the spare worker instead of starting a thread each
+    {
+        wsp::workbranch one(1);
+        for (int i = 0; i < 10; ++i) {
+            assert(one.submit<wsp::task::blk>([i] { return i; }).get() == i);
+        }
+        auto spawned = one.stats().spawned;
+        std::cout << "threads started for 10 regions: " << spawned - 1 << std::endl;
+        assert(spawned <= 1 + 2);  // a second one when a region starts before the last one ended
+        while (one.num_workers() != 1) std::this_thread::yield();  // the spare retires when unused
+        assert(one.num_compensating() == 0);
+    }
+
+    // regions past the cap do not compensate
+    {
+        wsp::workbranch one(1);
+        one.set_max_compensating(2);
+        std::promise<void> open;
+        auto wait = open.get_future().share();
+        for (int i = 0; i < 4; ++i) one.submit<wsp::task::blk>([wait] { wait.wait(); });
+        while (one.num_tasks() > 1) std::this_thread::yield();  // the last one has no worker left
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(one.num_compensating() == 2 && one.num_workers() == 3);
+        assert(one.num_tasks() == 1);
+        open.set_value();
+        one.wait_tasks();
+    }
+}
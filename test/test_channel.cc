@@ -0,0 +1,71 @@
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <workspace/workspace.hpp>
+
+int main() {
+    // one worker: the consumer waits on the channel while the producer is still queued behind it
+    wsp::workbranch br(1);
+    wsp::channel<int> ch(4);  // bounded
+    long sum = 0;
+    br.submit([&] {
+        int v;
+        while (ch.recv(v)) sum += v;
+    });
+    br.submit([&] {
+        for (int i = 1; i <= 1000; ++i) ch.send(i);
+        ch.close();
+    });
+    br.wait_tasks();
+    std::cout << "sum: " << sum << " | workers after: " << br.num_workers() << std::endl;
+    assert(sum == 500500);
+    assert(!ch.send(1));  // closed
+
+    // select over channels of different types
+    wsp::channel<int> nums;
+    wsp::channel<std::string> words;
+    int got_nums = 0, got_words = 0;
+    wsp::selector sel;
+    sel.on(nums, [&](int) { ++got_nums; }).on(words, [&](std::string) { ++got_words; });
+    br.submit([&] {
+        for (int i = 0; i < 100; ++i) {
+            nums.send(i);
+            words.send("w");
+        }
+        nums.close();
+        words.close();
+    });
+    while (sel.wait()) {
+    }
+    br.wait_tasks();
+    std::cout << "select: " << got_nums << " nums, " << got_words << " words" << std::endl;
+    assert(got_nums == 100 && got_words == 100);
+
+    // more waiters than the compensating cap: past it a waiter helps run the queued producer
+    wsp::workbranch capped(1);
+    capped.set_max_compensating(2);
+    wsp::channel<int> jobs(2), left, right;
+    std::atomic<int> received{0};
+    for (int i = 0; i < 6; ++i) {
+        capped.submit([&] {
+            int v;
+            if (jobs.recv(v)) ++received;
+        });
+    }
+    for (int i = 0; i < 2; ++i) {
+        capped.submit([&] {
+            wsp::selector pick;
+            pick.on(left, [&](int) { ++received; }).on(right, [&](int) { ++received; });
+            pick.wait();
+        });
+    }
+    capped.submit([&] {
+        for (int i = 0; i < 6; ++i) jobs.send(i);
+        left.send(0);
+        right.send(0);
+    });
+    capped.wait_tasks();
+    std::cout << "capped: " << received << " received | compensating: " << capped.num_compensating()
+              << std::endl;
+    assert(received == 8);
+}
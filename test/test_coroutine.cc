@@ -0,0 +1,113 @@
+#include <cassert>
+#include <iostream>
+#include <workspace/workspace.hpp>
+
+#if defined(WSP_HAS_COROUTINES)
+
+wsp::co_task<int> twice(wsp::workbranch& br, int v) {
+    co_await br.schedule();
+    co_return v * 2;
+}
+
+wsp::co_task<int> sum(wsp::workbranch& a, wsp::workbranch& b) {
+    int res = 0;
+    for (int i = 0; i < 100; ++i) {
+        res += co_await twice(i % 2 ? a : b, i);  // hop between branches
+    }
+    res += co_await wsp::async_submit(b, [](int x) { return x; }, 100);  // suspends, no worker blocks
+    co_await wsp::resume_on(a);
+    co_return res;
+}
+
+wsp::co_task<> fail(wsp::workspace& spc) {
+    co_await spc.schedule();
+    co_await wsp::async_submit(spc, [] { throw std::logic_error("A logic error"); });
+}
+
+// submits to its branch from the cleanup path when its resume is dropped
+wsp::co_task<int> resubmit(wsp::workbranch& br, std::atomic_bool& cleaned) {
+    try {
+        co_await br.schedule();
+    } catch (const wsp::task_cancelled&) {
+        br.submit([] {});  // dropped, the branch is shutting down, but must not block
+        cleaned = true;
+        throw;
+    }
+    co_return 1;
+}
+
+int main() {
+    wsp::workbranch a(2), b(1);
+    assert(wsp::sync_wait(sum(a, b)) == 2 * 4950 + 100);
+    assert(wsp::spawn(a, sum(a, b)).get() == 2 * 4950 + 100);
+    std::cout << "co_await: ok" << std::endl;
+
+    wsp::workspace spc;
+    spc.attach(new wsp::workbranch(2));
+    try {
+        wsp::sync_wait(fail(spc));
+        assert(false);
+    } catch (const std::logic_error& e) {
+        std::cout << "caught: " << e.what() << std::endl;
+    }
+
+    // a resume dropped by a shutdown unwinds the coroutine instead of leaking it
+    {
+        wsp::workbranch c(1);
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        std::promise<void> busy;
+        c.submit([gate, &busy] {
+            busy.set_value();
+            gate.wait();
+        });
+        busy.get_future().wait();
+        auto res = wsp::spawn(c, twice(c, 1));  // queued behind the gate
+        assert(!c.shutdown(wsp::shutdown_mode::discard, std::chrono::milliseconds(0)));
+        release.set_value();
+        try {
+            res.get();
+            assert(false);
+        } catch (const wsp::task_cancelled& e) {
+            std::cout << "dropped: " << e.what() << std::endl;
+        }
+    }
+
+    // the cancelled coroutine runs outside the queue lock, so its cleanup may submit to the same branch
+    {
+        std::atomic_bool cleaned{false};
+        wsp::workbranch c(1);
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        std::promise<void> busy;
+        c.submit([gate, &busy] {
+            busy.set_value();
+            gate.wait();
+        });
+        busy.get_future().wait();
+        bool cancelled = false;
+        std::thread waiter([&c, &cleaned, &cancelled] {
+            try {
+                wsp::sync_wait(resubmit(c, cleaned));  // suspends in schedule(), queued behind the gate
+            } catch (const wsp::task_cancelled&) {
+                cancelled = true;
+            }
+        });
+        while (c.num_tasks() != 1) std::this_thread::yield();
+        c.submit([] {});  // dropped after the resume
+        assert(!c.shutdown(wsp::shutdown_mode::discard, std::chrono::milliseconds(0)));
+        assert(cleaned);
+        release.set_value();
+        waiter.join();
+        assert(cancelled);
+        std::cout << "cleanup submitted: ok" << std::endl;
+    }
+}
+
+#else
+
+int main() {
+    std::cout << "coroutines need C++20, skipped" << std::endl;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <workspace/workspace.hpp>
+
+// count how many workbranches a policy spreads 16 * 100 tasks over
+size_t spread(wsp::workspace& spc) {
+    std::mutex lok;
+    std::map<std::thread::id, int> used;
+    for (int i = 0; i < 1600; ++i) {
+        spc.submit([&] {
+            std::lock_guard<std::mutex> lock(lok);
+            used[std::this_thread::get_id()]++;
+        });
+    }
+    spc.for_each([](wsp::workbranch& each) { each.wait_tasks(); });
+    return used.size();
+}
+
+// hold the single worker of a branch and queue `backlog` tasks behind it
+void load(wsp::workbranch& br, std::atomic_bool& gate, int backlog) {
+    br.submit([&gate] {
+        while (!gate) std::this_thread::yield();
+    });
+    for (int i = 0; i < backlog; ++i) br.submit([] {});
+    while (br.num_tasks() != static_cast<size_t>(backlog)) std::this_thread::yield();
+}
+
+int main() {
+    // placement of the built-in policies, on three loaded branches and an idle one
+    {
+        std::atomic_bool gate{false};
+        wsp::workbranch b0(1), b1(1), b2(1), idle(1);
+        load(b0, gate, 30);
+        load(b1, gate, 20);
+        load(b2, gate, 10);
+        std::vector<wsp::workbranch*> brs{&b0, &b1, &b2, &idle};
+
+        // round robin: strict rotation in attach order
+        wsp::details::dispatcher rr(wsp::dispatch::round_robin);
+        for (size_t i = 0; i < 8; ++i) assert(rr.pick(brs) == brs[i % 4]);
+
+        // least loaded: always the idle branch, whatever the starting offset
+        wsp::details::dispatcher least(wsp::dispatch::least_loaded);
+        for (int i = 0; i < 8; ++i) assert(least.pick(brs) == &idle);
+
+        // power of two: the two samples differ, so with two branches the shorter queue always wins
+        std::vector<wsp::workbranch*> pair{&b2, &idle};
+        wsp::details::dispatcher p2(wsp::dispatch::power_of_two);
+        for (int i = 0; i < 100; ++i) assert(p2.pick(pair) == &idle);
+        // and the longest queue is never picked among four
+        for (int i = 0; i < 100; ++i) assert(p2.pick(brs) != &b0);
+
+        // adjacent: the shorter of the branch under the cursor and the next one
+        wsp::details::dispatcher adj(wsp::dispatch::adjacent);
+        assert(adj.pick(brs) == &b1);    // b0 vs b1
+        assert(adj.pick(brs) == &b2);    // b1 vs b2
+        assert(adj.pick(brs) == &idle);  // b2 vs idle
+        assert(adj.pick(brs) == &idle);  // idle vs b0
+        gate = true;
+        std::cout << "placement: ok" << std::endl;
+    }
+
+    const char* names[] = {"adjacent", "round_robin", "power_of_two", "least_loaded"};
+    int i = 0;
+    for (auto how : {wsp::dispatch::adjacent, wsp::dispatch::round_robin, wsp::dispatch::power_of_two,
+                     wsp::dispatch::least_loaded}) {
+        wsp::workspace spc(how);
+        for (int j = 0; j < 16; ++j) spc.attach(new wsp::workbranch(1));
+        auto used = spread(spc);
+        std::cout << names[i++] << ": " << used << " of 16 branches used" << std::endl;
+        if (how == wsp::dispatch::round_robin) assert(used == 16);  // 100 tasks on every branch
+        assert(used >= 1 && used <= 16);
+    }
+
+    // user-supplied policy: always the last branch
+    wsp::workspace spc([](const std::vector<wsp::workbranch*>& brs) -> size_t { return brs.size() - 1; });
+    spc.attach(new wsp::workbranch(1));
+    auto last = spc.attach(new wsp::workbranch(1));
+    auto tid = spc.submit([] { return std::this_thread::get_id(); }).get();
+    auto expect = spc[last].submit([] { return std::this_thread::get_id(); }).get();
+    assert(tid == expect);
+    std::cout << "custom: ok" << std::endl;
+}
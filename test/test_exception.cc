@@ -15,12 +15,20 @@ public:
     }
 };
 
+void report(std::exception_ptr ex) {
+    try {
+        std::rethrow_exception(ex);
+    } catch (std::exception& e) {
+        std::cerr << "Collected error: " << e.what() << std::endl;
+    }
+}
+
 int main() {
     wsp::workbranch wbr;
 
-    wbr.submit([] { throw std::logic_error("A logic error"); });      // log error
-    wbr.submit([] { throw std::runtime_error("A runtime error"); });  // log error
-    wbr.submit([] { throw excep("XXXX"); });                          // log error
+    wbr.submit([] { throw std::logic_error("A logic error"); });      // collect error
+    wbr.submit([] { throw std::runtime_error("A runtime error"); });  // collect error
+    wbr.submit([] { throw excep("XXXX"); });                          // collect error
 
     auto future1 = wbr.submit([] {
         throw std::bad_alloc();
@@ -41,4 +49,18 @@ int main() {
     } catch (std::exception& e) {
         std::cerr << "Caught error: " << e.what() << std::endl;
     }
-}
\ No newline at end of file
+
+    // exceptions of void tasks are kept until drained
+    for (auto& ex : wbr.drain_exceptions()) {
+        report(ex);
+    }
+
+    // or handled by a callback (at most 10 per second, the rest are counted)
+    wbr.set_error_handler([](std::exception_ptr ex) { report(ex); }, 10);
+    for (int i = 0; i < 1000; ++i) {
+        wbr.submit([] { throw excep("ZZZZ"); });
+    }
+    wbr.wait_tasks();
+    auto st = wbr.stats();
+    std::cerr << "failed: " << st.failed << " | suppressed: " << st.suppressed << std::endl;
+}
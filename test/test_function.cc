@@ -55,6 +55,17 @@ void safe_exec(T& e) {
     }
 }
 
+// counts live objects: every construction must be matched by a destruction
+struct Counted {
+    static int live;
+    Counted() { ++live; }
+    Counted(const Counted&) { ++live; }
+    Counted(Counted&&) { ++live; }
+    ~Counted() { --live; }
+    void operator()() {}
+};
+int Counted::live = 0;
+
 void seperate() {
     cout<<"---------------------------------\n";
 }
@@ -108,4 +119,16 @@ int main() {
         // a = b;
         b = a;
     }
+    // a move destroys the moved-from callable left in the source's buffer
+    {
+        seperate();
+        {
+            task_t a{Counted()};
+            task_t b = std::move(a);
+            task_t c;
+            c = std::move(b);
+            assert(Counted::live == 1);
+        }
+        assert(Counted::live == 0);
+    }
 }
@@ -0,0 +1,51 @@
+#include <cassert>
+#include <cstdlib>
+#include <fcntl.h>
+#include <workspace/workspace.hpp>
+
+void round_trip(wsp::io_backend backend) {
+    wsp::workbranch cpu(2);
+    wsp::iobranch io(cpu, backend);
+    std::cout << "io_uring: " << std::boolalpha << io.uses_io_uring() << std::endl;
+
+    char path[] = "/tmp/wsp_iobranch_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+
+    const int blocks = 64, size = 4096;
+    std::vector<std::vector<char>> out(blocks, std::vector<char>(size));
+    wsp::futures<ssize_t> written;
+    for (int i = 0; i < blocks; ++i) {
+        std::fill(out[i].begin(), out[i].end(), static_cast<char>('a' + i % 26));
+        written.add_back(io.async_write(fd, out[i].data(), size, static_cast<off_t>(i) * size));
+    }
+    for (auto n : written.get()) assert(n == size);
+
+    // completions run on the cpu branch
+    std::vector<std::vector<char>> in(blocks, std::vector<char>(size));
+    std::atomic_int verified{0};
+    for (int i = 0; i < blocks; ++i) {
+        io.async_read(fd, in[i].data(), size, static_cast<off_t>(i) * size, [&, i](ssize_t n) {
+            assert(n == size && in[i] == out[i]);
+            ++verified;
+        });
+    }
+    io.wait_tasks();
+    cpu.wait_tasks();
+    assert(verified == blocks);
+
+    char buf[16];
+    try {
+        io.async_read(-1, buf, sizeof(buf), 0).get();
+        assert(false);
+    } catch (const std::system_error& e) {
+        std::cout << "caught: " << e.what() << std::endl;
+    }
+    close(fd);
+}
+
+int main() {
+    round_trip(wsp::io_backend::automatic);
+    round_trip(wsp::io_backend::threads);
+}
@@ -0,0 +1,59 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    wsp::workbranch br(2);
+
+    for (int i = 0; i < 1000; ++i) {
+        br.submit([] {});
+    }
+    for (int i = 0; i < 10; ++i) {
+        br.submit([] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    }
+    br.submit<wsp::task::seq>([] {}, [] {}, [] {});  // counts once
+    br.wait_tasks();
+
+    auto st = br.stats();
+    assert(st.submitted == 1011);
+    assert(st.completed == 1011);
+    assert(st.execution.max() >= 1000000);  // >= 1ms
+
+    std::cout << "submitted: " << st.submitted << " | completed: " << st.completed << " | workers: " << st.workers
+              << " | utilisation: " << st.utilisation() << std::endl;
+    std::cout << "queue-wait(ns) p50: " << st.queue_wait.percentile(50) << " p99: " << st.queue_wait.percentile(99)
+              << " p99.9: " << st.queue_wait.percentile(99.9) << std::endl;
+    std::cout << "execution(ns)  p50: " << st.execution.percentile(50) << " p99: " << st.execution.percentile(99)
+              << " max: " << st.execution.max() << std::endl;
+
+    // the histogram keeps percentiles within 6.25%
+    wsp::histogram_snapshot hist;
+    for (uint64_t v = 1; v <= 100000; ++v) hist.record(v);
+    assert(hist.percentile(50) >= 50000 && hist.percentile(50) <= 53125);
+
+    // a worker reusing the slot of a retired one starts its own lifetime
+    {
+        wsp::workbranch one(1);
+        one.submit([] {
+            wsp::blocking_region region;  // starts a second worker, retired at the end
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        });
+        one.wait_tasks();
+        while (one.num_workers() != 1) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));  // the free slot ages
+
+        // between the two snapshots, each of the two live workers ages by at most the time elapsed
+        auto t1 = std::chrono::steady_clock::now();
+        auto before = one.stats();
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        one.submit([gate] {
+            wsp::blocking_region region;  // the second worker takes the free slot
+            gate.wait();
+        });
+        while (one.num_workers() != 2) std::this_thread::yield();
+        auto after = one.stats();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t1);
+        release.set_value();
+        assert(after.worker_ns - before.worker_ns <= 2 * static_cast<uint64_t>(elapsed.count()));
+    }
+}
@@ -0,0 +1,48 @@
+#include <cassert>
+#include <numeric>
+#include <random>
+#include <workspace/workspace.hpp>
+
+int main() {
+    wsp::workbranch br(4);
+    std::mt19937 rng(42);
+    std::vector<int> data(1 << 20);
+    for (auto& each : data) each = static_cast<int>(rng() % 1000000);
+
+    // sort
+    auto expected = data;
+    std::sort(expected.begin(), expected.end());
+    auto sorted = data;
+    wsp::parallel_sort(br, sorted.begin(), sorted.end());
+    assert(sorted == expected);
+    auto desc = data;
+    wsp::parallel_sort(br, desc.begin(), desc.end(), std::greater<int>());
+    assert(std::is_sorted(desc.begin(), desc.end(), std::greater<int>()));
+
+    // reduce
+    auto sum = wsp::parallel_reduce(br, data.begin(), data.end(), 0LL);
+    assert(sum == std::accumulate(data.begin(), data.end(), 0LL));
+
+    // inclusive scan, out of place and in place
+    std::vector<long long> wide(data.begin(), data.end());
+    std::vector<long long> prefix(wide.size()), check(wide.size());
+    std::partial_sum(wide.begin(), wide.end(), check.begin());
+    wsp::parallel_inclusive_scan(br, wide.begin(), wide.end(), prefix.begin());
+    assert(prefix == check);
+    wsp::parallel_inclusive_scan(br, wide.begin(), wide.end(), wide.begin());
+    assert(wide == check);
+
+    // small inputs stay sequential
+    std::vector<int> small{3, 1, 2};
+    wsp::parallel_sort(br, small.begin(), small.end());
+    assert((small == std::vector<int>{1, 2, 3}));
+
+    // called from a worker of the same branch: the caller takes the chunks nobody else started
+    br.submit([&] {
+        auto again = data;
+        wsp::parallel_sort(br, again.begin(), again.end());
+        assert(again == expected);
+    });
+    br.wait_tasks();
+    std::cout << "sum: " << sum << " | max prefix: " << check.back() << std::endl;
+}
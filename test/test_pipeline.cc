@@ -0,0 +1,56 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+struct item {
+    int input = 0;
+    long squared = 0;
+};
+
+int main() {
+    wsp::workbranch br(4);
+    constexpr int count = 10000;
+    constexpr size_t tokens = 8;
+
+    int produced = 0, peak = 0;  // touched by the serial input stage only
+    std::atomic_int in_flight{0}, unordered{0};
+    std::vector<long> output;
+
+    wsp::pipeline<item> pl(tokens);
+    pl.source([&](item& it) {
+        if (produced == count) return false;
+        it.input = produced++;
+        peak = std::max(peak, ++in_flight);
+        return true;
+    });
+    pl.stage(wsp::stage_mode::parallel, [](item& it) { it.squared = long(it.input) * it.input; });
+    pl.stage(wsp::stage_mode::serial_out_of_order, [&](item&) { ++unordered; });
+    pl.stage(wsp::stage_mode::serial_in_order, [&](item& it) {
+        output.push_back(it.squared);
+        --in_flight;
+    });
+    pl.run(br);
+
+    std::cout << "items: " << output.size() << " | peak in flight: " << peak << std::endl;
+    assert(output.size() == count);
+    assert(unordered == count);
+    assert(peak <= int(tokens));
+    for (int i = 0; i < count; ++i) assert(output[i] == long(i) * i);  // in input order
+
+    // the first exception stops the input and is rethrown by run()
+    produced = 0;
+    output.clear();
+    wsp::pipeline<item> failing(tokens);
+    failing.source([&](item& it) {
+        it.input = produced++;
+        return true;  // endless, stopped by the error
+    });
+    failing.stage(wsp::stage_mode::parallel, [](item& it) {
+        if (it.input == 100) throw std::runtime_error("bad item");
+    });
+    try {
+        failing.run(br);
+        assert(false);
+    } catch (const std::runtime_error& e) {
+        std::cout << "caught: " << e.what() << " after " << produced << " items" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <workspace/workspace.hpp>
+
+// read until EAGAIN (edge-triggered)
+static size_t drain(int fd) {
+    char buf[256];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) total += n;
+    return total;
+}
+
+int main() {
+    wsp::workbranch br(2);
+    wsp::reactor rc;
+
+    // pipe: every byte is seen, callbacks of one fd never overlap
+    {
+        int p[2];
+        assert(pipe2(p, O_NONBLOCK) == 0);
+        std::atomic<size_t> got{0};
+        std::atomic_int inside{0};
+        rc.add(p[0], EPOLLIN, br, [&](uint32_t) {
+            assert(inside.fetch_add(1) == 0);
+            got += drain(p[0]);
+            inside.fetch_sub(1);
+        });
+        for (int i = 0; i < 1000; ++i) {
+            assert(write(p[1], "x", 1) == 1);
+        }
+        while (got.load() < 1000) std::this_thread::yield();
+        assert(rc.remove(p[0]));
+        br.wait_tasks();  // a callback already dispatched may still run
+        close(p[0]);
+        close(p[1]);
+        std::cout << "pipe: ok" << std::endl;
+    }
+
+    // eventfd
+    {
+        int efd = eventfd(0, EFD_NONBLOCK);
+        std::atomic<uint64_t> sum{0};
+        rc.add(efd, EPOLLIN, br, [&](uint32_t) {
+            uint64_t v;
+            while (read(efd, &v, sizeof(v)) == sizeof(v)) sum += v;
+        });
+        for (uint64_t i = 1; i <= 100; ++i) {
+            assert(write(efd, &i, sizeof(i)) == sizeof(i));
+        }
+        while (sum.load() < 5050) std::this_thread::yield();
+        rc.remove(efd);
+        br.wait_tasks();
+        close(efd);
+        std::cout << "eventfd: ok" << std::endl;
+    }
+
+    // loopback tcp: accept and echo on the branch
+    {
+        int srv = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        assert(bind(srv, reinterpret_cast<sockaddr*>(&addr), len) == 0 && listen(srv, 8) == 0);
+        getsockname(srv, reinterpret_cast<sockaddr*>(&addr), &len);
+
+        std::atomic_int conn{-1};
+        rc.add(srv, EPOLLIN, br, [&](uint32_t) {
+            int fd = accept4(srv, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) return;
+            conn = fd;
+            rc.add(fd, EPOLLIN, br, [fd](uint32_t) {
+                char buf[64];
+                ssize_t n;
+                while ((n = read(fd, buf, sizeof(buf))) > 0) assert(write(fd, buf, n) == n);
+            });
+        });
+
+        int cli = socket(AF_INET, SOCK_STREAM, 0);
+        assert(connect(cli, reinterpret_cast<sockaddr*>(&addr), len) == 0);
+        assert(write(cli, "ping", 4) == 4);
+        char buf[4];
+        assert(read(cli, buf, 4) == 4 && std::string(buf, 4) == "ping");
+        rc.remove(conn);
+        rc.remove(srv);
+        br.wait_tasks();
+        close(conn);
+        close(cli);
+        close(srv);
+        std::cout << "socket: ok" << std::endl;
+    }
+}
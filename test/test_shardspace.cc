@@ -0,0 +1,44 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    constexpr size_t shards = 4;
+    constexpr int rounds = 20000;
+    uint64_t owned[shards] = {};  // each counter is only touched by its own shard
+
+    {
+        wsp::shardspace space(shards);
+        assert(space.size() == shards);
+        assert(space.this_shard() == wsp::shardspace::npos);
+
+        // every shard sends messages to every shard, through the lock-free lanes
+        space.broadcast([&](size_t self) {
+            assert(space.this_shard() == self);
+            for (int i = 0; i < rounds; ++i) {
+                auto to = (self + i) % shards;
+                space.submit_to(to, [&owned, &space, to] {
+                    assert(space.this_shard() == to);
+                    ++owned[to];
+                });
+            }
+        });
+        assert(space.wait_tasks());
+
+        // per-lane order is kept: the last message sent to a shard runs last
+        std::vector<int> seen;
+        space.submit_to(1, [&] {
+            for (int i = 0; i < 1000; ++i) space.submit_to(2, [&seen, i] { seen.push_back(i); });
+        });
+        space.wait_tasks();
+        for (int i = 0; i < 1000; ++i) assert(seen[i] == i);
+
+        // read a shard's state from outside
+        auto total = space.submit_to(3, [&] { return owned[3]; }).get();
+        std::cout << "shard 3 ran: " << total << std::endl;
+        assert(total == rounds);
+    }
+    uint64_t sum = 0;
+    for (auto each : owned) sum += each;
+    std::cout << "messages: " << sum << std::endl;
+    assert(sum == shards * rounds);
+}
@@ -0,0 +1,106 @@
+#include <cassert>
+#include <dirent.h>
+#include <workspace/workspace.hpp>
+
+using namespace std::chrono;
+
+// threads of this process (Linux)
+static int count_threads() {
+    int n = 0;
+    if (auto dir = opendir("/proc/self/task")) {
+        while (auto each = readdir(dir)) n += each->d_name[0] != '.';
+        closedir(dir);
+    }
+    return n;
+}
+
+int main() {
+    // drain: every queued task runs, then the workers are joined
+    {
+        std::atomic_int ran{0};
+        wsp::workbranch br(2);
+        for (int i = 0; i < 1000; ++i) br.submit([&ran] { ++ran; });
+        assert(br.shutdown(wsp::shutdown_mode::drain));
+        std::cout << "drained: " << ran << std::endl;
+        assert(ran == 1000);
+    }
+
+    // discard: the queued tasks are dropped, their futures are broken
+    {
+        wsp::workbranch br(1);
+        br.submit([] { std::this_thread::sleep_for(milliseconds(50)); });
+        auto fut = br.submit([] { return 1; });
+        assert(br.shutdown(wsp::shutdown_mode::discard));
+        try {
+            fut.get();
+            assert(false);
+        } catch (const std::future_error& e) {
+            assert(e.code() == std::future_errc::broken_promise);
+        }
+    }
+
+    // cancel: the queued tasks are skipped, their futures throw task_cancelled
+    {
+        std::atomic_int ran{0};
+        wsp::workbranch br(1);
+        br.submit([] { std::this_thread::sleep_for(milliseconds(50)); });
+        auto fut = br.submit([] { return 1; });
+        for (int i = 0; i < 10; ++i) br.submit([&ran] { ++ran; });
+        assert(br.shutdown(wsp::shutdown_mode::cancel));
+        bool cancelled = false;
+        try {
+            fut.get();
+        } catch (const wsp::task_cancelled&) {
+            cancelled = true;
+        }
+        assert(cancelled && ran == 0);
+    }
+
+    // bounded: a stuck task makes shutdown return false, the destructor joins it later
+    {
+        std::atomic_bool release{false};
+        wsp::workbranch br(2);
+        br.submit([&release] {
+            while (!release) std::this_thread::sleep_for(milliseconds(1));
+        });
+        assert(!br.shutdown(wsp::shutdown_mode::drain, milliseconds(20)));
+        release = true;
+    }
+
+    // from its own worker: shutdown starts and returns at once instead of waiting for itself
+    {
+        wsp::workbranch br(2);
+        auto start = steady_clock::now();
+        auto fut = br.submit([&br] { return br.shutdown(wsp::shutdown_mode::drain, milliseconds(10000)); });
+        assert(!fut.get());
+        assert(steady_clock::now() - start < milliseconds(5000));
+        assert(br.is_shutdown());
+        assert(br.shutdown());  // the worker left once its task returned
+    }
+
+    // compensating workers that retire are joined, not detached: none is left once shutdown returns
+    {
+        int before = count_threads();
+        wsp::workbranch br(1);
+        for (int i = 0; i < 5; ++i) {
+            std::promise<void> release;
+            auto gate = release.get_future().share();
+            br.submit<wsp::task::blk>([gate] { gate.wait(); });
+            br.submit([] { return 0; }).wait();  // a compensating worker runs it
+            release.set_value();
+            br.wait_tasks();
+            while (br.num_workers() != 1) std::this_thread::yield();
+        }
+        assert(br.shutdown());
+        assert(count_threads() == before);
+    }
+
+    // destruction joins at once, no polling
+    auto start = steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        wsp::workbranch br(4);
+        br.submit([] {});
+    }
+    std::cout << "100 branches destroyed in "
+              << duration_cast<milliseconds>(steady_clock::now() - start).count() << "ms" << std::endl;
+}
@@ -0,0 +1,90 @@
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <workspace/snapshot.hpp>
+#include <workspace/workspace.hpp>
+
+// counts live copies of the published value
+struct counted {
+    static std::atomic_int live;
+    int value = 0;
+    counted() { ++live; }
+    counted(const counted& other) : value(other.value) { ++live; }
+    ~counted() { --live; }
+};
+std::atomic_int counted::live{0};
+
+int main() {
+    // every replaced version is freed once its readers leave, even with readers running throughout
+    {
+        {
+            wsp::details::snapshot<counted> snap;
+            std::atomic_bool done{false};
+            std::vector<std::thread> readers;
+            for (int i = 0; i < 4; ++i) {
+                readers.emplace_back([&snap, &done] {
+                    int last = 0;
+                    while (!done) {
+                        auto r = snap.read();
+                        assert(r->value >= last);  // never an older or freed version
+                        last = r->value;
+                    }
+                });
+            }
+            for (int i = 1; i <= 2000; ++i) {
+                snap.update([i](counted& c) { c.value = i; });
+                assert(counted::live <= 2);  // the new version, and the old one only during update
+            }
+            done = true;
+            for (auto& each : readers) each.join();
+            assert(counted::live == 1 && snap.read()->value == 2000);
+        }
+        assert(counted::live == 0);
+        std::cout << "reclaim: ok" << std::endl;
+    }
+
+    // several producers submit while branches are attached and detached: every task runs exactly once
+    {
+        constexpr int producers = 4;
+        constexpr int per_producer = 200000;  // at most
+        constexpr int replacements = 100;
+        std::unique_ptr<std::atomic_int[]> runs(new std::atomic_int[producers * per_producer]);
+        for (int i = 0; i < producers * per_producer; ++i) runs[i] = 0;
+
+        wsp::workspace spc(wsp::dispatch::round_robin);
+        std::vector<wsp::workspace::bid> ids;
+        for (int i = 0; i < 2; ++i) ids.push_back(spc.attach(new wsp::workbranch(1)));
+
+        std::atomic_bool stop{false};
+        std::vector<int> submitted(producers, 0);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&spc, &runs, &stop, &submitted, p] {
+                int n = 0;
+                for (; n < per_producer && !stop; ++n) {
+                    auto i = p * per_producer + n;
+                    spc.submit([&runs, i] { ++runs[i]; });
+                }
+                submitted[p] = n;
+            });
+        }
+        for (int churn = 0; churn < replacements; ++churn) {
+            ids.push_back(spc.attach(new wsp::workbranch(1)));  // attach first: one branch stays attached
+            auto gone = spc.detach(ids.front());
+            ids.erase(ids.begin());
+            assert(gone);
+            assert(gone->shutdown(wsp::shutdown_mode::drain));  // the tasks queued on it go with it and run
+        }
+        stop = true;
+        for (auto& each : threads) each.join();
+        spc.for_each([](wsp::workbranch& each) { each.wait_tasks(); });
+
+        int total = 0;
+        for (int p = 0; p < producers; ++p) {
+            for (int n = 0; n < per_producer; ++n) assert(runs[p * per_producer + n] == (n < submitted[p] ? 1 : 0));
+            total += submitted[p];
+        }
+        std::cout << "attach/detach while submitting: ok (" << total << " tasks, " << replacements
+                  << " branches replaced)" << std::endl;
+    }
+}
@@ -0,0 +1,121 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    // tasks of one key keep their order, whichever branch runs them
+    {
+        wsp::workspace spc(wsp::dispatch::round_robin);
+        for (int i = 0; i < 4; ++i) spc.attach(new wsp::workbranch(2));
+
+        std::vector<std::vector<int>> seen(8);
+        for (int i = 0; i < 1000; ++i) {
+            for (int key = 0; key < 8; ++key) {
+                spc.submit_keyed(key, [&seen, key, i] { seen[key].push_back(i); });
+            }
+        }
+        auto res = spc.submit_keyed(std::string("session"), [](int a, int b) { return a + b; }, 20, 22);
+        assert(res.get() == 42);
+
+        for (int key = 0; key < 8; ++key) {
+            spc.submit_keyed(key, [] { return 0; }).wait();  // all previous tasks of the key are done
+            for (int i = 0; i < 1000; ++i) assert(seen[key][i] == i);
+        }
+        std::cout << "keyed: ok" << std::endl;
+    }
+
+    // a strand on a multi-thread workbranch needs no lock
+    {
+        wsp::workbranch br(4);
+        wsp::strand st(br);
+        int count = 0;
+        for (int i = 0; i < 10000; ++i) {
+            st.submit([&count] { ++count; });
+        }
+        st.submit([] { throw std::logic_error("A logic error"); });  // log error
+        assert(st.submit([&count] { return count; }).get() == 10000);
+        std::cout << "strand: ok" << std::endl;
+    }
+
+    // a drain dropped by a detached branch does not wedge the strand
+    {
+        wsp::workspace spc;
+        auto first = spc.attach(new wsp::workbranch(1));
+        std::promise<void> gate;
+        auto opened = gate.get_future().share();
+        std::promise<void> busy;
+        spc[first].submit([opened, &busy] {
+            busy.set_value();
+            opened.wait();
+        });
+        busy.get_future().wait();
+
+        wsp::strand st(spc);
+        std::vector<int> seen;
+        st.submit([&seen] { seen.push_back(1); });  // its drain queues behind the gate
+        spc.attach(new wsp::workbranch(1));
+        auto gone = spc.detach(first);
+        assert(!gone->shutdown(wsp::shutdown_mode::discard, std::chrono::milliseconds(0)));  // drops the drain
+        gate.set_value();
+        gone.reset();
+
+        assert(st.submit([&seen] {
+                     seen.push_back(2);
+                     return seen.size();
+                 }).get() == 2);
+        assert(seen[0] == 1 && seen[1] == 2);
+        std::cout << "dropped drain: ok" << std::endl;
+    }
+
+    // close() waits for the running drain, which then stops instead of posting its next batch
+    {
+        wsp::workbranch br(2);
+        wsp::strand st(br);
+        std::atomic_int ran{0};
+        std::promise<void> busy;
+        st.submit([&busy] {
+            busy.set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        for (int i = 0; i < 1000; ++i) st.submit([&ran] { ++ran; });
+        busy.get_future().wait();
+        st.close();
+        auto after = ran.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(ran == after && after < 1000);
+        std::cout << "close: ok (" << after << " ran)" << std::endl;
+    }
+
+    // tasks discarded by close() are destroyed outside the strand's lock: their destructor may submit
+    {
+        struct resubmit {
+            wsp::strand* st;
+            std::shared_ptr<int> token = std::make_shared<int>(0);  // owned by the last copy
+            ~resubmit() {
+                if (token.use_count() == 1) st->submit([] {});  // ignored, the strand is closed
+            }
+            void operator()() const {}
+        };
+        wsp::workbranch br(1);
+        wsp::strand st(br);
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        br.submit([gate] { gate.wait(); });  // keeps the drain queued
+        for (int i = 0; i < 3; ++i) st.submit(resubmit{&st});
+        st.close();
+        release.set_value();
+        br.wait_tasks();
+        std::cout << "close destroys outside the lock: ok" << std::endl;
+    }
+
+    // a workspace destroyed while its keyed strands are mid-batch never submits to a dying branch
+    for (int round = 0; round < 20; ++round) {
+        wsp::workspace spc;
+        for (int i = 0; i < 3; ++i) spc.attach(new wsp::workbranch(1));
+        for (int i = 0; i < 500; ++i) {
+            spc.submit_keyed(i % 4, [i] {
+                if (i % 97 == 0) throw std::runtime_error("keyed");  // the drain re-posts from its catch
+            });
+        }
+    }
+    std::cout << "destroyed mid-batch: ok" << std::endl;
+}
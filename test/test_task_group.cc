@@ -0,0 +1,86 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    wsp::workbranch br(2);
+
+    // all good
+    std::atomic_int done{0};
+    {
+        wsp::task_group group(br);
+        for (int i = 0; i < 100; ++i) group.run([&done] { ++done; });
+        group.wait();
+        assert(done == 100);
+    }
+
+    // the first failure skips the siblings that have not started
+    std::atomic_int ran{0};
+    wsp::task_group group(br);
+    group.run([] { throw std::runtime_error("bad request"); });
+    for (int i = 0; i < 1000; ++i) {
+        group.run([&ran, &group] {
+            if (group.is_cancelled()) return;  // running tasks may stop early too
+            ++ran;
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        });
+    }
+    bool thrown = false;
+    try {
+        group.wait();
+    } catch (const wsp::task_group_error& e) {
+        thrown = true;
+        std::cout << e.what() << " | ran: " << ran << " of 1000" << std::endl;
+        assert(e.errors().size() >= 1);
+    }
+    assert(thrown);
+    assert(ran < 1000);
+
+    // usable again after wait, and wait() helps when called from a worker of the branch
+    auto sum = br.submit([&br] {
+        std::atomic_int total{0};
+        wsp::task_group inner(br);
+        for (int i = 1; i <= 10; ++i) {
+            inner.run([&br, &total, i] {
+                wsp::task_group leaf(br);
+                leaf.run([&total, i] { total += i; });
+                leaf.wait();
+            });
+        }
+        inner.wait();
+        return total.load();
+    });
+    assert(sum.get() == 55);
+
+    // several failures are all reported
+    size_t accepted = 0;
+    accepted += group.run([] { throw std::logic_error("a"); });
+    accepted += group.run([] { throw std::logic_error("b"); });  // refused once "a" failed
+    thrown = false;
+    try {
+        group.wait();
+    } catch (const wsp::task_group_error& e) {
+        thrown = true;
+        std::cout << e.what() << std::endl;
+        assert(e.errors().size() >= 1 && e.errors().size() <= accepted);
+    }
+    assert(thrown);
+
+    // tasks the branch drops at shutdown count as done: wait() returns
+    {
+        wsp::workbranch one(1);
+        std::promise<void> release, busy;
+        auto gate = release.get_future().share();
+        one.submit([gate, &busy] {
+            busy.set_value();
+            gate.wait();
+        });
+        busy.get_future().wait();
+        wsp::task_group dropped(one);
+        for (int i = 0; i < 10; ++i) assert(dropped.run([] { assert(false); }));
+        assert(!one.shutdown(wsp::shutdown_mode::discard, std::chrono::milliseconds(0)));
+        assert(!dropped.run([] {}));  // refused after shutdown
+        dropped.wait();
+        release.set_value();
+        std::cout << "dropped tasks: ok" << std::endl;
+    }
+}
@@ -0,0 +1,45 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+int main() {
+    std::atomic_int started{0}, stopped{0};
+    {
+        wsp::workbranch br(4);
+        wsp::worker_local<uint64_t> counts(br);
+
+        br.on_worker_start([&] {
+            assert(wsp::this_worker::branch() == &br);
+            counts.local() = 0;
+            ++started;
+        });
+        br.on_worker_stop([&] { ++stopped; });
+
+        // every task bumps the counter of the worker running it, no shared atomic
+        for (int i = 0; i < 10000; ++i) {
+            br.submit([&counts] {
+                assert(wsp::this_worker::index() < 4);
+                ++counts.local();
+            });
+        }
+        br.wait_tasks();
+
+        uint64_t total = 0;
+        counts.for_each([&total](uint64_t& each) { total += each; });
+        std::cout << "total: " << total << " | workers started: " << started << std::endl;
+        assert(total == 10000);
+
+        // outside a worker
+        assert(wsp::this_worker::branch() == nullptr);
+        assert(wsp::this_worker::index() == size_t(-1));
+        bool thrown = false;
+        try {
+            counts.local();
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    // the stop hook ran on every worker before the branch was gone
+    std::cout << "workers stopped: " << stopped << std::endl;
+    assert(stopped == 4);
+}
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <workspace/topology.hpp>
+
+int main() {
+    using wsp::details::topology;
+
+    auto hw = topology::hardware_cores();
+    auto cores = topology::effective_cores();
+    std::cout << "hardware: " << hw << " | affinity: " << topology::affinity_cores()
+              << " | effective: " << cores << " | quota: " << topology::quota_cores() << std::endl;
+    assert(hw >= 1);
+    assert(cores >= 1 && cores <= hw);
+    if (topology::affinity_cores() > 0) assert(cores <= topology::affinity_cores());
+    assert(topology::refresh() == cores);
+    assert(topology::multiple(2) == 2 * cores);
+    assert(topology::multiple(0.5) == (cores + 1) / 2);
+
+    // the cpus of the affinity mask agree with their count
+    auto cpus = topology::affinity_cpus();
+    auto affinity = topology::affinity_cores();
+    std::cout << "affinity cpus: " << cpus.size() << std::endl;
+    assert(cpus.size() == affinity);
+    assert(std::is_sorted(cpus.begin(), cpus.end()));
+    assert(std::adjacent_find(cpus.begin(), cpus.end()) == cpus.end());
+
+    // pinning to an allowed cpu succeeds (or is a no-op where unsupported) and narrows the mask to it
+    std::thread([&cpus, cores] {
+        if (cpus.empty()) {
+            assert(!topology::pin_current_thread(0));
+            return;
+        }
+        auto target = cpus.back();
+        assert(topology::pin_current_thread(target));
+        auto now = topology::thread_cpus();
+        assert(now.size() == 1 && now.front() == target);
+        // the process mask, and so the core count, ignore the pinned thread
+        assert(topology::affinity_cpus() == cpus);
+        assert(topology::refresh() == cores);
+    }).join();
+    // out of range
+    assert(!topology::pin_current_thread(1u << 30));
+    std::cout << "pinning: ok" << std::endl;
+}
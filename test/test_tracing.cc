@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <sstream>
+#include <workspace/workspace.hpp>
+
+static size_t count(const std::string& text, const std::string& what) {
+    size_t n = 0;
+    for (auto pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) ++n;
+    return n;
+}
+
+static wsp::trace_event make_event(int64_t i) {
+    return wsp::trace_event{nullptr, static_cast<uint64_t>(i), static_cast<uint64_t>(i), i, i, i, i};
+}
+
+int main() {
+    using wsp::details::trace_ring;
+
+    // the ring keeps the newest events, oldest first
+    {
+        trace_ring ring(8);
+        for (int64_t i = 0; i < 20; ++i) ring.push(make_event(i));
+        std::vector<wsp::trace_event> events;
+        ring.collect(events);
+        assert(events.size() == 8);
+        for (size_t i = 0; i < events.size(); ++i) assert(events[i].submit == static_cast<int64_t>(12 + i));
+        std::cout << "ring: ok" << std::endl;
+    }
+
+    // a reader running beside the writer never sees a torn event
+    {
+        trace_ring ring(8);
+        std::atomic_bool done{false};
+        std::thread writer([&] {
+            for (int64_t i = 0; i < 200000; ++i) ring.push(make_event(i));
+            done = true;
+        });
+        size_t seen = 0;
+        while (!done.load()) {
+            std::vector<wsp::trace_event> events;
+            ring.collect(events);
+            assert(events.size() <= 8);
+            for (auto& ev : events) {
+                assert(ev.branch == static_cast<uint64_t>(ev.submit) && ev.end == ev.submit);
+            }
+            seen += events.size();
+        }
+        writer.join();
+        std::cout << "seqlock: ok (" << seen << " events read)" << std::endl;
+    }
+
+    // Chrome Trace JSON: one complete event and one queue span per task, labels escaped
+    {
+        std::vector<wsp::trace_event> events = {
+            {"say \"hi\"\n", 1, 1, 1000, 3000, 4000, 9000},
+            {nullptr, 1, 2, 2000, 2500, 2500, 3000},
+            {"other", 2, 1, 5000, 5000, 6000, 7000},
+        };
+        std::ostringstream os;
+        wsp::details::write_chrome_trace(os, events);
+        auto json = os.str();
+        assert(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+        assert(json.substr(json.size() - 3) == "]}\n");
+        assert(count(json, "\"ph\":\"X\"") == 3);
+        assert(count(json, "\"ph\":\"b\"") == 3 && count(json, "\"ph\":\"e\"") == 3);
+        assert(count(json, "\"process_name\"") == 2);
+        assert(json.find("say \\\"hi\\\"\\n") != std::string::npos);
+        assert(json.find("\"name\":\"task\"") != std::string::npos);
+        // timestamps are us relative to the first submit
+        assert(json.find("\"ts\":3.000,\"dur\":5.000,\"args\":{\"queue_wait_us\":2.000,\"dequeue_to_start_us\":1.000}") !=
+               std::string::npos);
+        std::cout << "json: ok" << std::endl;
+    }
+
+    // a task stuck behind another shows its queue wait
+    {
+        wsp::workbranch br(1);
+        br.enable_tracing(64);
+        std::promise<void> release;
+        auto gate = release.get_future().share();
+        br.submit([gate] { gate.wait(); });
+        {
+            wsp::trace_label label("gated");
+            br.submit([] {});
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release.set_value();
+        br.wait_tasks();
+
+        auto events = br.trace_events();
+        assert(events.size() == 2);
+        for (auto& ev : events) {
+            assert(ev.submit <= ev.dequeue && ev.dequeue <= ev.start && ev.start <= ev.end);
+            if (ev.label && std::strcmp(ev.label, "gated") == 0) {
+                assert(ev.dequeue - ev.submit >= 15000000);  // waited for the gate
+            }
+        }
+        std::cout << "branch: ok" << std::endl;
+    }
+
+    // traces of retired workers are bounded: compensating workers come and go
+    {
+        wsp::workbranch br(1);
+        br.enable_tracing(64);
+        for (int i = 0; i < 40; ++i) {
+            std::promise<void> release;
+            auto gate = release.get_future().share();
+            br.submit<wsp::task::blk>([gate] { gate.wait(); });
+            {
+                wsp::trace_label label("quick");
+                br.submit([] { return 0; }).wait();  // a compensating worker runs it
+            }
+            release.set_value();
+            br.wait_tasks();
+            while (br.num_workers() != 1) std::this_thread::yield();
+        }
+        std::vector<uint64_t> workers;  // that ran a traced quick task
+        for (auto& ev : br.trace_events()) {
+            if (!ev.label || std::strcmp(ev.label, "quick") != 0) continue;
+            if (std::find(workers.begin(), workers.end(), ev.worker) == workers.end()) workers.push_back(ev.worker);
+        }
+        std::cout << "workers still traced: " << workers.size() << std::endl;
+        assert(workers.size() <= 16 + 1);  // the last 16 retired ones and the live one
+    }
+}
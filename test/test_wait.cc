@@ -0,0 +1,54 @@
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+// every call waits for its two halves, submitted to the same branch
+long fib(wsp::workbranch& br, int n) {
+    if (n < 2) return n;
+    auto left = br.submit([&br, n] { return fib(br, n - 1); });
+    auto right = br.submit([&br, n] { return fib(br, n - 2); });
+    return wsp::get(left) + wsp::get(right);
+}
+
+// every link waits for the next one: helping alone would nest them all on one stack
+int chain(wsp::workbranch& br, int n, std::atomic_int& deepest) {
+    int nesting = wsp::details::worker_context::local().nesting;
+    for (int seen = deepest.load(); nesting > seen && !deepest.compare_exchange_weak(seen, nesting);) {
+    }
+    if (n == 0) return 0;
+    auto next = br.submit([&br, n, &deepest] { return chain(br, n - 1, deepest); });
+    return wsp::get(next) + 1;
+}
+
+int main() {
+    // two workers, hundreds of tasks waiting at once: a plain get() would deadlock
+    wsp::workbranch br(2);
+    auto res = br.submit([&br] { return fib(br, 15); }).get();
+    std::cout << "fib(15): " << res << " | workers: " << br.num_workers() << std::endl;
+    assert(res == 610);
+
+    // deep recursion: helpers run the newest tasks first, so the stack grows with the recursion only
+    res = br.submit([&br] { return fib(br, 25); }).get();
+    std::cout << "fib(25): " << res << " | workers: " << br.num_workers() << std::endl;
+    assert(res == 75025);
+
+    // a chain longer than the nesting cap blocks past it instead of overflowing the stack
+    std::atomic_int deepest{0};
+    assert(br.submit([&br, &deepest] { return chain(br, 300, deepest); }).get() == 300);
+    std::cout << "chain(300): deepest nesting " << deepest.load() << std::endl;
+    assert(deepest.load() <= wsp::details::worker_context::max_nesting);
+
+    // futures::get helps as well
+    auto total = br.submit([&br] {
+        wsp::futures<int> parts;
+        for (int i = 0; i < 100; ++i) parts.add_back(br.submit([i] { return i; }));
+        int sum = 0;
+        for (auto each : parts.get()) sum += each;
+        return sum;
+    });
+    assert(total.get() == 4950);
+
+    // outside a worker it simply waits
+    auto fut = br.submit([] { return 1; });
+    wsp::wait(fut);
+    assert(fut.get() == 1);
+}
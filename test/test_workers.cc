@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cassert>
+#include <workspace/workspace.hpp>
+
+// wait until the branch has `num` workers
+static void settle(wsp::workbranch& br, size_t num) {
+    while (br.num_workers() != num) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// live workers agree with the slot table, the spawn/exit counters and, once quiet, the idle count
+static void check_counts(wsp::workbranch& br) {
+    auto st = br.stats();
+    assert(st.workers == br.num_workers());
+    assert(st.spawned - st.exited == st.workers);
+    assert(br.num_compensating() < br.num_workers());  // spares never outnumber the workers
+    br.wait_tasks();
+    assert(br.count_idle_workers(std::chrono::milliseconds(0)) == br.num_workers());
+}
+
+int main() {
+    constexpr size_t max_workers = 6;
+
+    // a supervisor grows and shrinks the branch again and again: freed slots are reused
+    {
+        auto br = std::make_shared<wsp::workbranch>(1);
+        std::atomic<size_t> top_index{0};
+        {
+            wsp::supervisor sp(1, max_workers, std::chrono::milliseconds(5), std::chrono::milliseconds(1));
+            sp.supervise(br, 1, max_workers, std::chrono::milliseconds(5));
+            for (int round = 0; round < 10; ++round) {
+                for (int i = 0; i < 100; ++i) {
+                    br->submit([&top_index] {
+                        auto idx = wsp::this_worker::index();
+                        auto cur = top_index.load();
+                        while (idx > cur && !top_index.compare_exchange_weak(cur, idx)) {
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    });
+                }
+                br->wait_tasks();
+                settle(*br, 1);  // the idle ones are deleted
+            }
+        }
+        auto st = br->stats();
+        std::cout << "spawned: " << st.spawned << " | exited: " << st.exited << " | top index: " << top_index
+                  << std::endl;
+        assert(st.spawned > max_workers);  // more workers came and went than there are slots
+        assert(top_index < max_workers);   // yet none needed a slot beyond the peak
+        check_counts(*br);
+    }
+
+    // the supervisor adds and deletes while blocking regions start and retire compensating workers
+    {
+        auto br = std::make_shared<wsp::workbranch>(2);
+        {
+            wsp::supervisor sp(1, max_workers, std::chrono::milliseconds(2), std::chrono::milliseconds(1));
+            sp.supervise(br, 1, max_workers, std::chrono::milliseconds(2));
+            std::atomic_bool done{false};
+            std::thread watcher([&br, &done] {
+                while (!done) {
+                    auto st = br->stats();  // taken under the branch lock: a consistent view
+                    assert(st.spawned - st.exited == st.workers);
+                    auto comp = br->num_compensating();
+                    assert(comp <= br->num_workers() + 1);  // one may be spawning in between
+                    std::this_thread::yield();
+                }
+            });
+            for (int round = 0; round < 20; ++round) {
+                for (int i = 0; i < 50; ++i) {
+                    if (i % 5 == 0) {
+                        br->submit<wsp::task::blk>([] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+                    } else {
+                        br->submit([] { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+                    }
+                }
+                br->wait_tasks();
+            }
+            done = true;
+            watcher.join();
+        }
+        check_counts(*br);
+        settle(*br, br->num_workers() - br->num_compensating());  // the spares retire
+        assert(br->num_compensating() == 0);
+        check_counts(*br);
+        std::cout << "concurrent add/del: ok (" << br->stats().spawned << " spawned)" << std::endl;
+    }
+}